@@ -0,0 +1,397 @@
+// Benchmarks for the reflection hot paths.
+//
+//   g++ -std=c++17 -O2 -pthread bench.cpp -lbenchmark -o bench && ./bench
+//
+// Every benchmark reports allocs/op: global operator new is replaced below
+// and counts, per thread, the allocations made inside the timed loop.
+#include "reflection.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <new>
+#include <random>
+
+namespace {
+
+thread_local uint64_t allocations = 0;
+
+} // namespace
+
+// Out of line, so the compiler does not pair inlined malloc/free calls
+// against new/delete expressions and warn about a mismatch.
+__attribute__((noinline)) void* operator new(std::size_t size) {
+    ++allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return ::operator new(size); }
+__attribute__((noinline)) void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { ::operator delete(p); }
+void operator delete(void* p, std::size_t) noexcept { ::operator delete(p); }
+void operator delete[](void* p, std::size_t) noexcept { ::operator delete(p); }
+
+namespace {
+
+using namespace reflection;
+
+// Counts allocations from construction to report(), for the current thread.
+class AllocationCounter {
+public:
+    explicit AllocationCounter(benchmark::State& state) : state(state), start(allocations) {}
+
+    void report() {
+        state.counters["allocs/op"] = benchmark::Counter(
+            static_cast<double>(allocations - start), benchmark::Counter::kAvgIterations);
+    }
+
+private:
+    benchmark::State& state;
+    uint64_t start;
+};
+
+A& benchObject() {
+    static A object("bench_object");
+    return object;
+}
+
+// Runs cmd through the text protocol, building a result string per call
+// (parseAndExecute) or reusing one (execute).
+void runCommand(benchmark::State& state, std::string_view cmd, bool reuseResult) {
+    benchObject();
+    std::string result;
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        if (reuseResult) {
+            benchmark::DoNotOptimize(ReflectionParser::execute(cmd, result));
+        } else {
+            benchmark::DoNotOptimize(ReflectionParser::parseAndExecute(cmd));
+        }
+    }
+    counter.report();
+}
+
+void BM_GetDirect(benchmark::State& state) { runCommand(state, "get bench_object.a", false); }
+void BM_GetNested(benchmark::State& state) { runCommand(state, "get bench_object.d.b", false); }
+void BM_SetDirect(benchmark::State& state) { runCommand(state, "set bench_object.a=42", false); }
+void BM_SetNested(benchmark::State& state) { runCommand(state, "set bench_object.d.b=hi", false); }
+void BM_ExecuteGetNested(benchmark::State& state) { runCommand(state, "get bench_object.d.a", true); }
+void BM_ExecuteSetNested(benchmark::State& state) { runCommand(state, "set bench_object.d.a=7", true); }
+
+BENCHMARK(BM_GetDirect);
+BENCHMARK(BM_GetNested);
+BENCHMARK(BM_SetDirect);
+BENCHMARK(BM_SetNested);
+BENCHMARK(BM_ExecuteGetNested);
+BENCHMARK(BM_ExecuteSetNested);
+
+// The same commands through the path specialized for A at compile time.
+void runTyped(benchmark::State& state, std::string_view cmd) {
+    benchObject();
+    std::string result;
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ReflectionParser::executeAs<A>(cmd, result));
+    }
+    counter.report();
+}
+
+void BM_TypedGetNested(benchmark::State& state) { runTyped(state, "get bench_object.d.a"); }
+void BM_TypedSetNested(benchmark::State& state) { runTyped(state, "set bench_object.d.a=7"); }
+
+BENCHMARK(BM_TypedGetNested);
+BENCHMARK(BM_TypedSetNested);
+
+// Results formatted into a caller buffer instead of a std::string.
+void BM_ExecuteIntoBuffer(benchmark::State& state) {
+    benchObject();
+    char buffer[64];
+    size_t length = 0;
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ReflectionParser::execute("get bench_object.d.b", buffer,
+                                                           sizeof(buffer), length));
+    }
+    counter.report();
+}
+BENCHMARK(BM_ExecuteIntoBuffer);
+
+void BM_CompiledGet(benchmark::State& state) {
+    benchObject();
+    PathHandle handle = ReflectionParser::compile("bench_object.d.a");
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(handle.get<int>());
+    }
+    counter.report();
+}
+BENCHMARK(BM_CompiledGet);
+
+// The legacy per-object member map, rebuilt on every call.
+void BM_Reflect(benchmark::State& state) {
+    A& object = benchObject();
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Reflector<A>::reflect(object));
+    }
+    counter.report();
+}
+BENCHMARK(BM_Reflect);
+
+void BM_MemberIndex(benchmark::State& state) {
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Reflector<A>::indexOf("d"));
+    }
+    counter.report();
+}
+BENCHMARK(BM_MemberIndex);
+
+// Registered Records named "obj_<i>"; rebuilt only when the size changes,
+// so each registry benchmark pays construction once per argument.
+struct Population {
+    std::vector<std::unique_ptr<Record>> objects;
+    std::vector<std::string> ids;
+    std::vector<std::string> handles;
+};
+
+const Population& population(size_t n) {
+    static Population current;
+    if (current.objects.size() != n) {
+        current = Population();
+        ObjectRegistry<Record>::reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            current.ids.push_back("obj_" + std::to_string(i));
+            current.objects.push_back(std::make_unique<Record>(current.ids.back()));
+            current.handles.push_back("#" + std::to_string(current.objects.back()->getHandle()));
+        }
+    }
+    return current;
+}
+
+// Lookups in a shuffled order, so large populations miss the cache.
+std::vector<size_t> lookupOrder(size_t n) {
+    std::vector<size_t> order(std::min<size_t>(n, 1 << 16));
+    std::mt19937_64 rng(n);
+    for (size_t& i : order) i = rng() % n;
+    return order;
+}
+
+template<bool ByHandle>
+void BM_RegistryLookup(benchmark::State& state) {
+    const Population& objects = population(static_cast<size_t>(state.range(0)));
+    const std::vector<std::string>& keys = ByHandle ? objects.handles : objects.ids;
+    std::vector<size_t> order = lookupOrder(keys.size());
+    size_t next = 0;
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ObjectRegistry<Record>::getObject(keys[order[next]]));
+        if (++next == order.size()) next = 0;
+    }
+    counter.report();
+}
+BENCHMARK_TEMPLATE(BM_RegistryLookup, false)->Arg(1000)->Arg(100000)->Arg(1000000);
+BENCHMARK_TEMPLATE(BM_RegistryLookup, true)->Arg(1000)->Arg(100000)->Arg(1000000);
+
+template<typename T>
+T sampleValue() {
+    if constexpr (std::is_same_v<T, bool>) {
+        return true;
+    } else if constexpr (std::is_arithmetic_v<T>) {
+        return static_cast<T>(12345.678);
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        return "a string value";
+    } else {
+        T value("bench_sample");
+        value.a = 17;
+        value.b = "nested";
+        return value;
+    }
+}
+
+template<typename T>
+void BM_ToString(benchmark::State& state) {
+    T value = sampleValue<T>();
+    std::string out;
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        out.clear();
+        append_value(out, value);
+        benchmark::DoNotOptimize(out.data());
+    }
+    counter.report();
+}
+
+template<typename T>
+void BM_FromString(benchmark::State& state) {
+    T source = sampleValue<T>();
+    std::string text;
+    append_value(text, source);
+    T target = sampleValue<T>();
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(assign_from_string(target, text));
+    }
+    counter.report();
+}
+
+BENCHMARK_TEMPLATE(BM_ToString, int);
+BENCHMARK_TEMPLATE(BM_ToString, int64_t);
+BENCHMARK_TEMPLATE(BM_ToString, double);
+BENCHMARK_TEMPLATE(BM_ToString, bool);
+BENCHMARK_TEMPLATE(BM_ToString, std::string);
+BENCHMARK_TEMPLATE(BM_ToString, Record);
+BENCHMARK_TEMPLATE(BM_FromString, int);
+BENCHMARK_TEMPLATE(BM_FromString, int64_t);
+BENCHMARK_TEMPLATE(BM_FromString, double);
+BENCHMARK_TEMPLATE(BM_FromString, bool);
+BENCHMARK_TEMPLATE(BM_FromString, std::string);
+BENCHMARK_TEMPLATE(BM_FromString, Record);
+
+// Two members staged and published as one change, and read back together.
+void BM_TransactionCommit(benchmark::State& state) {
+    benchObject();
+    Transaction txn;
+    int value = 0;
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        txn.set("bench_object.a", ++value);
+        txn.set("bench_object.d.a", value);
+        benchmark::DoNotOptimize(txn.commit());
+    }
+    counter.report();
+}
+BENCHMARK(BM_TransactionCommit);
+
+void BM_ConsistentRead(benchmark::State& state) {
+    benchObject();
+    int outer = 0, inner = 0;
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ReflectionParser::read({ "bench_object.a", "bench_object.d.a" },
+                                                        outer, inner));
+    }
+    counter.report();
+}
+BENCHMARK(BM_ConsistentRead)->ThreadRange(1, 8)->UseRealTime();
+
+// Contention: every thread reads the shared object and writes its own.
+std::array<std::unique_ptr<A>, 64>& threadObjects() {
+    static std::array<std::unique_ptr<A>, 64> objects = [] {
+        std::array<std::unique_ptr<A>, 64> made;
+        for (size_t i = 0; i < made.size(); ++i) {
+            made[i] = std::make_unique<A>("bench_thread_" + std::to_string(i));
+        }
+        return made;
+    }();
+    return objects;
+}
+
+void BM_ContendedGet(benchmark::State& state) {
+    benchObject();
+    std::string result;
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ReflectionParser::execute("get bench_object.d.a", result));
+    }
+    counter.report();
+}
+BENCHMARK(BM_ContendedGet)->ThreadRange(1, 8)->UseRealTime();
+
+void BM_ContendedSet(benchmark::State& state) {
+    threadObjects();
+    std::string cmd = "set bench_thread_" + std::to_string(state.thread_index()) + ".d.a=5";
+    std::string result;
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ReflectionParser::execute(cmd, result));
+    }
+    counter.report();
+}
+BENCHMARK(BM_ContendedSet)->ThreadRange(1, 8)->UseRealTime();
+
+// A batch of sets spread over many objects, on the calling thread or a pool.
+template<bool Parallel>
+void BM_Batch(benchmark::State& state) {
+    const Population& objects = population(1000);
+    std::vector<std::string> script;
+    for (size_t i = 0; i < 4096; ++i) {
+        script.push_back("set " + objects.ids[i % 256] + ".a=" + std::to_string(i));
+    }
+    std::vector<std::string_view> views(script.begin(), script.end());
+    CommandPool pool(static_cast<size_t>(state.range(0)));
+    BatchResult result;
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        if (Parallel) {
+            pool.execute(views.data(), views.size(), result);
+        } else {
+            ReflectionParser::executeBatch(views.data(), views.size(), result);
+        }
+    }
+    counter.report();
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(views.size()));
+}
+BENCHMARK_TEMPLATE(BM_Batch, false)->Arg(1)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Batch, true)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+// One field summed over n objects: a column sweep against per-object reads.
+template<bool Columnar>
+void BM_ScanField(benchmark::State& state) {
+    size_t n = static_cast<size_t>(state.range(0));
+    const Population& objects = population(n);
+    ReflectableColumnStore<Record> store;
+    store.reserve(n);
+    for (const auto& object : objects.objects) store.append(*object);
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        long sum = 0;
+        if (Columnar) {
+            for (int value : store.column<0>()) sum += value;
+        } else {
+            for (const auto& object : objects.objects) sum += object->a;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    counter.report();
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n));
+}
+BENCHMARK_TEMPLATE(BM_ScanField, false)->Arg(1000)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_ScanField, true)->Arg(1000)->Arg(100000);
+
+// Bulk creation of Records: plain values, or each one registered under an id.
+template<bool Registered>
+void BM_CreateRecords(benchmark::State& state) {
+    size_t n = static_cast<size_t>(state.range(0));
+    std::vector<std::string> ids;
+    for (size_t i = 0; i < n; ++i) ids.push_back("bench_create_" + std::to_string(i));
+    std::vector<std::unique_ptr<Record>> records(n);
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        for (size_t i = 0; i < n; ++i) {
+            records[i] = Registered ? std::make_unique<Record>(ids[i]) : std::make_unique<Record>();
+        }
+        for (auto& record : records) record.reset();
+    }
+    counter.report();
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n));
+}
+BENCHMARK_TEMPLATE(BM_CreateRecords, false)->Arg(10000);
+BENCHMARK_TEMPLATE(BM_CreateRecords, true)->Arg(10000);
+
+// Registration churn against lookups in the same index.
+void BM_ContendedRegister(benchmark::State& state) {
+    std::string id = "bench_churn_" + std::to_string(state.thread_index());
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        Record record(id);
+        benchmark::DoNotOptimize(ObjectRegistry<Record>::getObject(id));
+    }
+    counter.report();
+}
+BENCHMARK(BM_ContendedRegister)->ThreadRange(1, 8)->UseRealTime();
+
+} // namespace
+
+BENCHMARK_MAIN();
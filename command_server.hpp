@@ -0,0 +1,343 @@
+#pragma once
+
+#include "reflection.hpp"
+
+#include <cerrno>
+#include <climits>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+namespace reflection {
+
+// TCP front end for ReflectionParser: one epoll loop serving every
+// connection from a single thread. Clients send newline-delimited commands
+// and may pipeline any number of them; each readable event runs all
+// complete lines received so far as one parser batch and answers them in
+// order with a single writev. Every command gets one response:
+//   "+<length>\n<text>\n"   on success (text may itself contain newlines)
+//   "-<status name>\n"      on failure
+// Responses a slow client cannot take yet are queued on its connection,
+// and reading from it pauses until the queue drains. A client that shuts
+// down its sending side still gets answers to every complete line. Each
+// wakeup reads at most maxReadPerWakeup bytes from a connection, so one
+// client pipelining a large script cannot starve the others.
+//
+// "watch" is answered with "-no_subscriber": watches deliver events to
+// in-process subscribers, and this transport has no way to push them to
+// the client that asked.
+class CommandServer {
+public:
+    struct Options {
+        std::string address = "127.0.0.1";
+        uint16_t port = 0;              // 0 picks an ephemeral port
+        int backlog = 128;
+        size_t maxBatch = 256;          // commands per parser batch
+        size_t maxLine = 1 << 20;       // longer lines close the connection
+        size_t maxReadPerWakeup = 256 << 10;  // bytes read per readable event
+    };
+
+    CommandServer() : CommandServer(Options()) {}
+    explicit CommandServer(Options options) : options(std::move(options)) {}
+
+    ~CommandServer() {
+        for (auto& [fd, connection] : connections) ::close(fd);
+        if (listener >= 0) ::close(listener);
+        if (wakeup >= 0) ::close(wakeup);
+        if (poller >= 0) ::close(poller);
+    }
+
+    CommandServer(const CommandServer&) = delete;
+    CommandServer& operator=(const CommandServer&) = delete;
+
+    // Binds and listens. Returns false, with errno set, on failure.
+    bool start() {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(options.port);
+        if (::inet_pton(AF_INET, options.address.c_str(), &addr.sin_addr) != 1) {
+            errno = EINVAL;
+            return false;
+        }
+        listener = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listener < 0) return false;
+        int on = 1;
+        ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if (::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            ::listen(listener, options.backlog) != 0) {
+            return false;
+        }
+        socklen_t length = sizeof(addr);
+        ::getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &length);
+        boundPort = ntohs(addr.sin_port);
+
+        poller = ::epoll_create1(EPOLL_CLOEXEC);
+        wakeup = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (poller < 0 || wakeup < 0) return false;
+        return watch(listener, EPOLLIN) && watch(wakeup, EPOLLIN);
+    }
+
+    uint16_t port() const { return boundPort; }
+
+    // Serves connections until stop() is called.
+    void run() {
+        std::array<epoll_event, 64> events;
+        while (!stopping.load(std::memory_order_acquire)) {
+            int ready = ::epoll_wait(poller, events.data(), static_cast<int>(events.size()), -1);
+            if (ready < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            for (int i = 0; i < ready; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == listener) {
+                    acceptAll();
+                } else if (fd != wakeup) {
+                    serve(fd, events[i].events);
+                }
+            }
+        }
+    }
+
+    // Makes run() return; safe to call from any thread.
+    void stop() {
+        stopping.store(true, std::memory_order_release);
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t written = ::write(wakeup, &one, sizeof(one));
+    }
+
+private:
+    struct Connection {
+        std::string input;
+        size_t consumed = 0;    // bytes of input already executed
+        std::string pending;    // response bytes the socket has not taken
+        size_t sent = 0;        // bytes of pending already written
+        bool peerClosed = false;
+    };
+
+    Options options;
+    int listener = -1;
+    int poller = -1;
+    int wakeup = -1;
+    uint16_t boundPort = 0;
+    std::atomic<bool> stopping{false};
+    std::unordered_map<int, Connection> connections;
+
+    // Reused across batches so steady-state serving does not allocate.
+    BatchResult batch;
+    std::vector<std::string_view> commands;
+    std::string headers;
+    std::vector<iovec> iov;
+
+    bool watch(int fd, uint32_t events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        return ::epoll_ctl(poller, EPOLL_CTL_ADD, fd, &event) == 0;
+    }
+
+    void rearm(int fd, uint32_t events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        ::epoll_ctl(poller, EPOLL_CTL_MOD, fd, &event);
+    }
+
+    void acceptAll() {
+        for (;;) {
+            int fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return;  // EAGAIN, or an error the next accept reports
+            int on = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            if (!watch(fd, EPOLLIN | EPOLLRDHUP)) {
+                ::close(fd);
+                continue;
+            }
+            connections.emplace(fd, Connection());
+        }
+    }
+
+    void drop(int fd) {
+        ::epoll_ctl(poller, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        connections.erase(fd);
+    }
+
+    void serve(int fd, uint32_t events) {
+        auto it = connections.find(fd);
+        if (it == connections.end()) return;
+        Connection& connection = it->second;
+
+        if (events & EPOLLOUT) {
+            if (!flushPending(fd, connection)) return drop(fd);
+            if (!connection.pending.empty()) return;
+            if (connection.peerClosed) return drop(fd);
+            rearm(fd, EPOLLIN | EPOLLRDHUP);
+        } else if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+            if (!receive(fd, connection) || !execute(fd, connection)) return drop(fd);
+            if (connection.peerClosed && connection.pending.empty()) return drop(fd);
+        }
+    }
+
+    // Reads what is available, up to maxReadPerWakeup bytes, noting end of
+    // input; false on a socket error. Anything left unread keeps the socket
+    // readable, so the level-triggered poller reports it again next round.
+    bool receive(int fd, Connection& connection) {
+        char chunk[16 * 1024];
+        for (size_t budget = options.maxReadPerWakeup; budget > 0;) {
+            ssize_t n = ::read(fd, chunk, std::min(sizeof(chunk), budget));
+            if (n > 0) {
+                connection.input.append(chunk, static_cast<size_t>(n));
+                budget -= static_cast<size_t>(n);
+            } else if (n == 0) {
+                connection.peerClosed = true;
+                return true;
+            } else if (errno != EINTR) {
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+        }
+        return true;
+    }
+
+    // Whether the line's first space-separated token is "watch".
+    static bool isWatch(std::string_view line) {
+        size_t start = line.find_first_not_of(' ');
+        if (start == std::string_view::npos) return false;
+        line.remove_prefix(start);
+        return operation_from_token(line.substr(0, line.find(' '))) == Operation::Watch;
+    }
+
+    // Runs the complete lines in the input, in batches of maxBatch, while
+    // the connection has no queued output. A watch line ends the batch
+    // before it and is rejected on its own. False on a protocol or socket error.
+    bool execute(int fd, Connection& connection) {
+        while (connection.pending.empty()) {
+            std::string_view input(connection.input);
+            commands.clear();
+            size_t pos = connection.consumed;
+            bool rejected = false;
+            while (commands.size() < options.maxBatch) {
+                size_t end = input.find('\n', pos);
+                if (end == std::string_view::npos) break;
+                std::string_view line = input.substr(pos, end - pos);
+                if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+                if (isWatch(line)) {
+                    if (commands.empty()) {
+                        rejected = true;
+                        pos = end + 1;
+                    }
+                    break;
+                }
+                commands.push_back(line);
+                pos = end + 1;
+            }
+            if (rejected) {
+                connection.consumed = pos;
+                if (!reject(fd, connection, Status::NoSubscriber)) return false;
+                continue;
+            }
+            if (commands.empty()) break;
+            ReflectionParser::executeBatch(commands.data(), commands.size(), batch);
+            connection.consumed = pos;
+            if (!respond(fd, connection)) return false;
+        }
+        // Drop executed input; an unterminated tail stays for the next read.
+        connection.input.erase(0, connection.consumed);
+        connection.consumed = 0;
+        return connection.input.size() <= options.maxLine;
+    }
+
+    // Writes the current batch's responses, queueing what does not fit.
+    bool respond(int fd, Connection& connection) {
+        static constexpr char newline = '\n';
+        headers.clear();
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (batch.status(i) == Status::Ok) {
+                headers += '+';
+                append_value(headers, batch.value(i).size());
+            } else {
+                headers += '-';
+                headers += statusName(batch.status(i));
+            }
+            headers += newline;
+        }
+
+        iov.clear();
+        const char* header = headers.data();
+        for (size_t i = 0; i < batch.size(); ++i) {
+            const char* end = static_cast<const char*>(
+                std::memchr(header, newline, headers.data() + headers.size() - header)) + 1;
+            iov.push_back({ const_cast<char*>(header), static_cast<size_t>(end - header) });
+            header = end;
+            if (batch.status(i) == Status::Ok) {
+                std::string_view value = batch.value(i);
+                if (!value.empty()) iov.push_back({ const_cast<char*>(value.data()), value.size() });
+                iov.push_back({ const_cast<char*>(&newline), 1 });
+            }
+        }
+        return send(fd, connection);
+    }
+
+    // Answers one command that was not run with a failure status.
+    bool reject(int fd, Connection& connection, Status status) {
+        headers.clear();
+        headers += '-';
+        headers += statusName(status);
+        headers += '\n';
+        iov.clear();
+        iov.push_back({ headers.data(), headers.size() });
+        return send(fd, connection);
+    }
+
+    // Writes the buffers in iov, queueing what does not fit.
+    bool send(int fd, Connection& connection) {
+        size_t done = 0;
+        while (done < iov.size()) {
+            int count = static_cast<int>(std::min<size_t>(iov.size() - done, IOV_MAX));
+            ssize_t n = ::writev(fd, iov.data() + done, count);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                return false;
+            }
+            size_t written = static_cast<size_t>(n);
+            while (done < iov.size() && written >= iov[done].iov_len) {
+                written -= iov[done++].iov_len;
+            }
+            if (written > 0) {
+                iov[done].iov_base = static_cast<char*>(iov[done].iov_base) + written;
+                iov[done].iov_len -= written;
+            }
+        }
+        if (done == iov.size()) return true;
+
+        // The socket is full: keep the rest and resume on EPOLLOUT.
+        for (size_t i = done; i < iov.size(); ++i) {
+            connection.pending.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+        }
+        rearm(fd, connection.peerClosed ? EPOLLOUT : EPOLLOUT | EPOLLRDHUP);
+        return true;
+    }
+
+    bool flushPending(int fd, Connection& connection) {
+        while (connection.sent < connection.pending.size()) {
+            ssize_t n = ::write(fd, connection.pending.data() + connection.sent,
+                                connection.pending.size() - connection.sent);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            connection.sent += static_cast<size_t>(n);
+        }
+        connection.pending.clear();
+        connection.sent = 0;
+        // Lines that arrived while output was blocked.
+        return execute(fd, connection);
+    }
+};
+
+} // namespace reflection
@@ -1,382 +1,750 @@
-#include <string>
-#include <sstream>
-#include <iostream>
-#include <vector>
-#include <map>
-#include <stdexcept>
-#include <type_traits>
-#include <memory>
-#include <boost/lexical_cast.hpp>
-
-namespace reflection {
-
-// Move these helper traits before TypeTraits
-template<typename T, typename = void>
-struct is_lexical_castable {
-private:
-    template<typename U>
-    static auto test(int) -> decltype(
-        boost::lexical_cast<U>(std::string()),
-        boost::lexical_cast<std::string>(std::declval<U>()),
-        std::true_type()
-    );
-
-    template<typename>
-    static auto test(...) -> std::false_type;
-
-public:
-    static constexpr bool value = 
-        !std::is_same_v<T, void> && 
-        std::is_default_constructible_v<T> &&
-        decltype(test<T>(0))::value;
-};
-
-template<typename T>
-inline constexpr bool is_lexical_castable_v = is_lexical_castable<T>::value;
-
-// Now TypeTraits can use is_lexical_castable_v
-template<typename T, typename = void>
-struct TypeTraits {
-    static T fromString(const std::string& str) {
-        static_assert(is_lexical_castable_v<T>, 
-            "Type must either support lexical_cast or have custom TypeTraits specialization");
-        return boost::lexical_cast<T>(str);
-    }
-    
-    static std::string toString(const T& val) {
-        static_assert(is_lexical_castable_v<T>, 
-            "Type must either support lexical_cast or have custom TypeTraits specialization");
-        return boost::lexical_cast<std::string>(val);
-    }
-};
-
-// Forward declarations
-template<typename T>
-struct Reflector;
-
-// Base class for member info
-class MemberInfoBase {
-public:
-    virtual ~MemberInfoBase() = default;
-    virtual std::string getValue() const = 0;
-    virtual bool setValue(const std::string& value) = 0;
-};
-
-// Templated member info implementation
-template<typename T>
-class MemberInfo : public MemberInfoBase {
-    T* member;
-public:
-    explicit MemberInfo(T* ptr) : member(ptr) {}
-
-    std::string getValue() const override {
-        return TypeTraits<T>::toString(*member);
-    }
-
-    bool setValue(const std::string& value) override {
-        try {
-            *member = TypeTraits<T>::fromString(value);
-            return true;
-        } catch (...) {
-            return false;
-        }
-    }
-};
+#include "reflection.hpp"
+#include "command_server.hpp"
 
-// Helper macros for member collection
-#define REFLECT_CONCAT_(x,y) x##y
-#define REFLECT_CONCAT(x,y) REFLECT_CONCAT_(x,y)
-#define REFLECT_STRINGIFY(x) #x
-#define REFLECT_COUNTER __COUNTER__
-
-// Object registry
-template<typename T>
-class ObjectRegistry {
-private:
-    static std::map<std::string, T*> objects;
-
-public:
-    static void registerObject(const std::string& id, T* obj) {
-        objects[id] = obj;
-    }
+#include <filesystem>
+#include <unistd.h>
 
-    static void unregisterObject(const std::string& id) {
-        objects.erase(id);
-    }
+// Outlives everything main touches; unregisters at exit.
+static reflection::Record late_static;
 
-    static T* getObject(const std::string& id) {
-        auto it = objects.find(id);
-        return it != objects.end() ? it->second : nullptr;
-    }
+// A schema with a bool member, for the column store.
+struct Switch : public reflection::Reflectable<Switch> {
+    REFLECT_MEMBER(bool, on, false)
+    REFLECT_MEMBER(int, level, 0)
 };
 
-// member_path -> T*
-template<typename T>
-std::map<std::string, T*> ObjectRegistry<T>::objects;
-
-// Add forward declaration at the top of the namespace, before Reflectable class
-template<typename T>
-struct Reflector;
-
-// Base class for reflectable objects - simplified version
-template<typename Derived>
-class Reflectable {
-    friend class Reflector<Derived>;
-
-private:
-    std::string _object_id;
-
-protected:
-    // Constructor requires explicit ID
-    explicit Reflectable(std::string id) {
-        static_assert(std::is_base_of_v<Reflectable<Derived>, Derived>,
-            "Derived class must inherit from Reflectable<Derived>");
-        _register_self(std::move(id));
+int main() {
+    using namespace reflection;
+    
+    A a("test_object");
+    
+    // Basic get/set for direct members
+    assert(ReflectionParser::parseAndExecute("set test_object.a=42") == "42");
+    assert(ReflectionParser::parseAndExecute("get test_object.a") == "42");
+    
+    // Nested member access
+    assert(ReflectionParser::parseAndExecute("set test_object.d.a=666") == "666");
+    assert(ReflectionParser::parseAndExecute("get test_object.d.a") == "666");
+    
+    // String member tests
+    assert(ReflectionParser::parseAndExecute("set test_object.d.b=hello_world") == "hello_world");
+    assert(ReflectionParser::parseAndExecute("get test_object.d.b") == "hello_world");
+    
+    // Static member tables
+    static_assert(Reflector<A>::member_count == 2);
+    static_assert(Reflector<Record>::member_count == 2);
+    assert(std::string(Reflector<Record>::descriptors[1].name) == "b");
+    static_assert(Reflector<A>::indexOf("a") == 0);
+    static_assert(Reflector<A>::indexOf("d") == 1);
+    static_assert(Reflector<A>::indexOf("nonreflectable") == npos_member);
+    assert(Reflector<A>::find(a, "d"));
+    assert(!Reflector<A>::find(a, "nonreflectable"));
+
+    // string_view overload over a caller-owned buffer
+    const char buffer[] = "get  test_object.d.a trailing";
+    assert(ReflectionParser::parseAndExecute(std::string_view(buffer, 20)) == "666");
+    assert(ReflectionParser::parseAndExecute(std::string("get test_object.a")) == "42");
+
+    // Whole nested objects and deeper paths
+    assert(ReflectionParser::parseAndExecute("get test_object.d") == "a=666,b=hello_world");
+    assert(Reflector<A>::resolve(a, "d.b").getValue() == "hello_world");
+    assert(ReflectionParser::parseAndExecute("get test_object.a.b").empty()); // Leaf has no members
+    assert(ReflectionParser::parseAndExecute("get test_object.d.invalid").empty());
+
+    // Precompiled path handles
+    PathHandle handle = ReflectionParser::compile("test_object.d.a");
+    assert(handle && handle.get() == "666");
+    assert(handle.set("777") && ReflectionParser::parseAndExecute("get test_object.d.a") == "777");
+    assert(!ReflectionParser::compile("test_object.d.invalid"));
+    {
+        A scoped("scoped_object");
+        PathHandle scopedHandle = ReflectionParser::compile("scoped_object.a");
+        assert(scopedHandle.set("5") && scoped.a == 5);
+        scoped.registerAs("renamed_object");
+        assert(!scopedHandle && scopedHandle.get().empty());
     }
-
-    void _register_self(std::string id) {
-        if (id.empty()) {
-            throw std::invalid_argument("Object ID cannot be empty");
-        }
-        _object_id = std::move(id);
-        ObjectRegistry<Derived>::registerObject(_object_id, static_cast<Derived*>(this));
+    {
+        // A new object at the same address under the same id, of another
+        // type or the same one, does not revive a handle into the old one.
+        alignas(A) alignas(Record) unsigned char storage[std::max(sizeof(A), sizeof(Record))];
+        A* slot = new (storage) A("slot");
+        PathHandle stale = ReflectionParser::compile("slot.d.b");
+        assert(stale.get() == "hello");
+        slot->~A();
+        Record* other = new (storage) Record("slot");
+        assert(!stale && !stale.set("x") && other->b.empty());
+        other->~Record();
+        slot = new (storage) A("slot");
+        assert(!stale && ReflectionParser::compile("slot.d.b"));
+        slot->~A();
     }
+    assert(handle.get() == "777");
+
+    // Typed access without string conversion
+    assert(ReflectionParser::set("test_object.d.a", 888));
+    assert(ReflectionParser::get<int>("test_object.d.a") == 888);
+    assert(ReflectionParser::set<std::string>("test_object.d.b", "typed"));
+    assert(ReflectionParser::get<std::string>("test_object.d.b") == "typed");
+    assert(!ReflectionParser::set("test_object.d.a", std::string("wrong type")));
+    assert(!ReflectionParser::get<double>("test_object.d.a"));
+    assert(handle.set(999) && handle.get<int>() == 999);
+    assert(ReflectionParser::parseAndExecute("set test_object.d.b=hello_world") == "hello_world");
 
-public:
-    const std::string& getObjectId() const { return _object_id; }
+    // charconv conversions
+    assert(TypeTraits<int>::fromString("+17") == 17);
+    assert(TypeTraits<double>::toString(0.1) == "0.1");
+    assert(TypeTraits<bool>::toString(true) == "1");
+    char digits[4];
+    assert(TypeTraits<int>::toChars(digits, digits + 4, 1234) == digits + 4);
+    assert(!TypeTraits<int>::toChars(digits, digits + 4, 12345));
+    assert(ReflectionParser::parseAndExecute("set test_object.a=12x").empty());
+    assert(ReflectionParser::parseAndExecute("set test_object.a=42") == "42");
 
-    void registerAs(const std::string& id) {
-        if (id.empty()) {
-            throw std::invalid_argument("Object ID cannot be empty");
+    // Error codes and non-throwing conversion
+    std::string result;
+    assert(ReflectionParser::execute("set test_object.a=oops", result) == Status::InvalidValue);
+    assert(a.a == 42);
+    assert(ReflectionParser::execute("set test_object.d=x,y", result) == Status::InvalidValue);
+    assert(ReflectionParser::execute("get missing.a", result) == Status::ObjectNotFound);
+    assert(ReflectionParser::execute("get test_object.zz", result) == Status::MemberNotFound);
+    assert(ReflectionParser::execute("put test_object.a", result) == Status::UnknownOperation);
+    assert(ReflectionParser::execute("get", result) == Status::InvalidCommand);
+    assert(ReflectionParser::execute("get test_object.d.a", result) == Status::Ok && result == "999");
+    int parsed = 0;
+    assert(!TypeTraits<int>::tryFromString("12x", parsed));
+
+    // Concurrent lookups alongside registration churn
+    {
+        std::vector<std::thread> readers;
+        std::atomic<bool> failed{false};
+        for (int t = 0; t < 4; ++t) {
+            readers.emplace_back([&failed] {
+                std::string value;
+                for (int i = 0; i < 1000; ++i) {
+                    if (ReflectionParser::execute("get test_object.a", value) != Status::Ok) {
+                        failed = true;
+                    }
+                }
+            });
         }
-        if (!_object_id.empty()) {
-            ObjectRegistry<Derived>::unregisterObject(_object_id);
+        for (int i = 0; i < 100; ++i) {
+            A churn("churn_" + std::to_string(i));
         }
-        _register_self(id);
+        for (auto& reader : readers) reader.join();
+        assert(!failed);
     }
 
-    virtual ~Reflectable() {
-        if (!_object_id.empty()) {
-            ObjectRegistry<Derived>::unregisterObject(_object_id);
+    // Flat hash registry: bulk registration, precomputed hashes, erasure
+    {
+        ObjectRegistry<A>::reserve(2000);
+        std::vector<std::unique_ptr<A>> bulk;
+        for (int i = 0; i < 2000; ++i) {
+            bulk.push_back(std::make_unique<A>("bulk_" + std::to_string(i)));
+        }
+        size_t hash = ObjectRegistry<A>::hashId("bulk_1234");
+        assert(ObjectRegistry<A>::getObject("bulk_1234", hash) == bulk[1234].get());
+        for (int i = 0; i < 2000; i += 2) bulk[i].reset();
+        for (int i = 0; i < 2000; ++i) {
+            A* found = ObjectRegistry<A>::getObject("bulk_" + std::to_string(i));
+            assert(found == bulk[i].get());
         }
     }
 
-    template<size_t N>
-    static constexpr auto _get_reflection_data(std::integral_constant<size_t, N>) {
-        if constexpr (N > 0) {
-            using MemberType = decltype(Derived::REFLECT_CONCAT(_reflect_member_, N-1));
-            return std::tuple_cat(
-                std::make_tuple(MemberType{}),
-                _get_reflection_data(std::integral_constant<size_t, N-1>{})
-            );
-        } else {
-            return std::make_tuple();
+    // Pooled ids: an object and its index key share one block
+    {
+        size_t live = IdPool::liveBlocks();
+        std::vector<std::unique_ptr<Record>> pooled;
+        for (int i = 0; i < 100; ++i) {
+            pooled.push_back(std::make_unique<Record>("pooled_" + std::to_string(i)));
         }
+        assert(IdPool::liveBlocks() == live + 100);
+        const char* keyData = nullptr;
+        ObjectIndex::forEach([&](std::string_view id, const ObjectRef&) {
+            if (id == "pooled_7") keyData = id.data();
+        });
+        assert(keyData == pooled[7]->getObjectId().data());
+
+        Record alias("pooled_7");  // rebinding reuses the interned id
+        assert(alias.getObjectId().data() == keyData);
+        assert(IdPool::liveBlocks() == live + 100);
+        pooled.clear();
+        assert(ObjectRegistry<Record>::getObject("pooled_7") == &alias);
+        assert(IdPool::liveBlocks() == live + 1);
     }
 
-    static constexpr auto _reflect_members() {
-        constexpr size_t count = REFLECT_COUNTER;
-        return _get_reflection_data(std::integral_constant<size_t, count>{});
+    // Values and members stay unregistered until named
+    {
+        size_t live = IdPool::liveBlocks();
+        size_t generation = ObjectIndex::getGeneration().load();
+        std::vector<Record> values(1000);
+        assert(!values[0].isRegistered() && values[0].getObjectId().empty() && values[0].getHandle() == 0);
+        assert(!ObjectRegistry<Record>::getObject("default") && !a.d.isRegistered());
+        assert(IdPool::liveBlocks() == live && ObjectIndex::getGeneration().load() == generation);
+
+        Record named("named_record");
+        named.a = 5;
+        Record copy(named);  // values copy, identity does not
+        assert(copy.a == 5 && !copy.isRegistered() && copy.getHandle() == 0);
+        values[1] = named;
+        assert(values[1].a == 5 && !values[1].isRegistered());
+        copy.a = 6;
+        named = copy;  // the target keeps its own registration
+        assert(named.a == 6 && named.getObjectId() == "named_record");
+        assert(ObjectRegistry<Record>::getObject("named_record") == &named);
+
+        // Constructed before the index was built, registered after it.
+        late_static.registerAs("late_static_record");
+        assert(ObjectRegistry<Record>::getObject("late_static_record") == &late_static);
+
+        values[2].registerAs("late_record");  // deferred registration
+        assert(ObjectRegistry<Record>::getObject("late_record") == &values[2] && values[2].getHandle() != 0);
+        assert(ReflectionParser::parseAndExecute("set late_record.b=late") == "late" && values[2].b == "late");
     }
-};
+    assert(!ObjectRegistry<Record>::getObject("late_record") && !ObjectRegistry<Record>::getObject("named_record"));
 
-// Helper macros for member reflection
-#define REFLECT_MEMBER(Type, Name, DefaultValue)                                \
-    Type Name = DefaultValue;                                                   \
-    struct REFLECT_CONCAT(member_info_, Name) {                                \
-        static constexpr const char* name = REFLECT_STRINGIFY(Name);           \
-        using type = Type;                                                     \
-        template<typename T>                                                   \
-        static auto pointer() {                                                \
-            return &T::Name;                                                  \
-        }                                                                      \
-    };                                                                         \
-    static constexpr auto REFLECT_CONCAT(_reflect_member_, REFLECT_COUNTER) = \
-        REFLECT_CONCAT(member_info_, Name){};
-
-// Example classes
-struct Record : public Reflectable<Record> {
-    REFLECT_MEMBER(int, a, 0)
-    REFLECT_MEMBER(std::string, b, "")
-
-    Record() : Reflectable<Record>("default") {}
-    explicit Record(std::string id) : Reflectable<Record>(std::move(id)) {}
-};
+    // Objects of any Reflectable type are addressable by id
+    a.d.registerAs("test_record");
+    assert(ReflectionParser::parseAndExecute("get test_record.b") == "hello_world");
+    assert(ReflectionParser::parseAndExecute("set test_record.a=31") == "31" && a.d.a == 31);
+    assert(ObjectRegistry<Record>::getObject("test_record") == &a.d);
+    assert(!ObjectRegistry<Record>::getObject("test_object"));
+    assert(ObjectIndex::find("test_object").type == &Reflector<A>::type);
 
-template<>
-struct TypeTraits<Record> {
-    static Record fromString(const std::string& str) {
-        Record r("default");
-        auto pos = str.find(',');
-        if (pos != std::string::npos) {
-            r.a = boost::lexical_cast<int>(str.substr(0, pos));
-            r.b = str.substr(pos + 1);
-        }
-        return r;
-    }
-    
-    static std::string toString(const Record& val) {
-        return std::to_string(val.a) + "," + val.b;
+    // Batch execution into one shared result buffer
+    {
+        BatchResult batch;
+        std::string_view commands[] = {
+            "set test_object.a=7", "get test_object.a", "get missing.a", "get test_object.d.b" };
+        ReflectionParser::executeBatch(commands, 4, batch);
+        assert(batch.size() == 4);
+        assert(batch.value(0) == "7" && batch.value(1) == "7");
+        assert(batch.status(2) == Status::ObjectNotFound && batch.value(2).empty());
+        assert(batch.value(3) == "hello_world");
+
+        ReflectionParser::executeBatch("set test_object.a=8;get test_object.a\r\n\nget test_object.x", batch);
+        assert(batch.size() == 3 && batch.value(1) == "8");
+        assert(batch.status(2) == Status::MemberNotFound);
     }
-};
-
-class A : public Reflectable<A> {
-public:
-    REFLECT_MEMBER(int, a, 1)
-    REFLECT_MEMBER(Record, d, Record("record_1"))
-    std::string nonreflectable = "nonreflectable";
 
-    explicit A(std::string id) 
-        : Reflectable<A>(std::move(id))
-        , d("record_1")
+    // Whole-object dump and load
+    assert(ReflectionParser::parseAndExecute("dump test_object") == "a=8,d.a=31,d.b=hello_world");
+    assert(ReflectionParser::parseAndExecute("dump test_record") == "a=31,b=hello_world");
+    assert(ReflectionParser::execute("load test_object a=3,d.a=4,d.b=loaded", result) == Status::Ok);
+    assert(a.a == 3 && a.d.a == 4 && a.d.b == "loaded");
+    assert(ReflectionParser::execute("load test_object d.zz=1", result) == Status::MemberNotFound);
+    assert(ReflectionParser::execute("load test_object", result) == Status::InvalidCommand);
+    assert(ReflectionParser::execute("dump missing", result) == Status::ObjectNotFound);
+
+    // Reflectable values convert through their member list, in place
+    assert(ReflectionParser::parseAndExecute("set test_object.d=a=9,b=nested") == "a=9,b=nested");
+    assert(&a.d == ObjectRegistry<Record>::getObject("test_record") && a.d.a == 9);
+    assert(TypeTraits<A>::toString(a) == "a=3,d.a=9,d.b=nested");
+    assert(ReflectionParser::execute("set test_object.d=a=bad", result) == Status::InvalidValue);
+    assert(ReflectionParser::execute("set test_object.d=a=5,zz=1", result) == Status::InvalidValue);
+    assert(a.d.a == 9 && a.d.b == "nested");  // a rejected field leaves the member whole
+    assert(Reflector<A>::reflect(a).at("d")->getValue() == "a=9,b=nested");
     {
-        d.a = 2;
-        d.b = "hello";
+        // Dumped values escape ',', ' ' and '\', and load back whole.
+        Record escaped("escaped_record");
+        escaped.b = "hello world, \\ done";
+        std::string dumped = ReflectionParser::parseAndExecute("dump escaped_record");
+        assert(dumped == "a=0,b=hello\\ world\\,\\ \\\\\\ done");
+        escaped.b.clear();
+        assert(ReflectionParser::execute("load escaped_record " + dumped + "  ", result) == Status::Ok);
+        assert(escaped.b == "hello world, \\ done");
+        escaped.b.clear();
+        assert(ReflectionParser::executeAs<Record>("load escaped_record " + dumped, result) == Status::Ok);
+        assert(escaped.b == "hello world, \\ done");
+        assert(ReflectionParser::execute("load escaped_record b=x\\ ", result) == Status::Ok && escaped.b == "x ");
+
+        A holder("escaped_holder");
+        assert(ReflectionParser::execute("set escaped_holder.d=b=p\\,a=9", result) == Status::Ok);
+        assert(holder.d.b == "p,a=9" && holder.d.a == 2);
+        assert(ReflectionParser::parseAndExecute("get escaped_holder.d") == "a=2,b=p\\,a=9");
     }
-};
 
-template<>
-struct TypeTraits<A> {
-    static A fromString(const std::string& str) {
-        A a("default");
-        auto pos = str.find('|');
-        if (pos != std::string::npos) {
-            a.a = boost::lexical_cast<int>(str.substr(0, pos));
-            a.d = TypeTraits<Record>::fromString(str.substr(pos + 1));
-        }
-        return a;
-    }
-    
-    static std::string toString(const A& val) {
-        return std::to_string(val.a) + "|" + TypeTraits<Record>::toString(val.d);
+    // Binary wire format
+    {
+        std::string wire;
+        BinaryCodec<A>::encode(a, wire);
+        assert(wire.size() == 8 + sizeof(int) * 2 + 1 + a.d.b.size());
+
+        A copy("wire_copy");
+        assert(BinaryCodec<A>::decode(wire, copy));
+        assert(copy.a == a.a && copy.d.a == a.d.a && copy.d.b == a.d.b);
+        assert(!BinaryCodec<A>::decode(std::string_view(wire).substr(0, wire.size() - 1), copy));
+        assert(!BinaryCodec<Record>::decode(wire, copy.d));
+        static_assert(BinaryCodec<A>::schema_hash != BinaryCodec<Record>::schema_hash);
     }
-};
 
-// Registry for reflected types
-template<typename T>
-struct Reflector {
-    using MemberMap = std::map<std::string, std::unique_ptr<MemberInfoBase>>;
-    
-    template<typename MemberInfoT, typename Obj>
-    static void add_to_map(MemberMap& members, Obj& obj) {
-        members[MemberInfoT::name] = std::make_unique<MemberInfo<typename MemberInfoT::type>>(
-            &(obj.*(MemberInfoT::template pointer<Obj>()))
-        );
+    // Snapshot and parallel restore of every registered object
+    {
+        // Per-process names in the system temp directory, so concurrent runs
+        // do not share files.
+        const std::filesystem::path dir = std::filesystem::temp_directory_path();
+        const std::string suffix = std::to_string(::getpid()) + ".bin";
+        const std::string path = (dir / ("iqtoy_snapshot_test_" + suffix)).string();
+        const std::string missing = (dir / ("iqtoy_missing_snapshot_" + suffix)).string();
+        a.a = 123;
+        a.d.b = "snapshot";
+        assert(Snapshot::save(path));
+        a.a = 0;
+        a.d.b.clear();
+        Snapshot::RestoreResult restored = Snapshot::restore(path, 4);
+        assert(restored.ok && restored.failed == 0 && restored.missing == 0);
+        assert(a.a == 123 && a.d.b == "snapshot");
+        std::filesystem::remove(path);
+        assert(!Snapshot::restore(missing).ok);
     }
 
-    template<typename Tuple, size_t... Is>
-    static MemberMap reflect_impl(T& obj, const Tuple& tuple, std::index_sequence<Is...>) {
-        MemberMap members;
-        (add_to_map<std::tuple_element_t<Is, Tuple>>(members, obj), ...);
-        return members;
+    // Change tracking and delta extraction
+    ReflectionParser::parseAndExecute("delta test_object");
+    assert(ReflectionParser::parseAndExecute("delta test_object").empty());
+    assert(ReflectionParser::parseAndExecute("set test_object.d.b=changed") == "changed");
+    assert(ReflectionParser::parseAndExecute("delta test_object") == "d.b=changed");
+    a.set_a(55);
+    assert(ReflectionParser::set("test_object.d.a", 66));
+    assert(ReflectionParser::parseAndExecute("delta test_object") == "a=55,d.a=66");
+    assert(ReflectionParser::parseAndExecute("set test_record.a=67") == "67");
+    assert(ReflectionParser::parseAndExecute("delta test_record") == "a=67");
+    assert(ReflectionParser::parseAndExecute("delta test_object").empty());
+    a.set_d(a.d);
+    ReflectionParser::set("test_record.b", std::string("replaced"));
+    assert(ReflectionParser::parseAndExecute("delta test_object") == "d.a=67,d.b=replaced");
+    assert(ReflectionParser::parseAndExecute("delta test_record").empty());
+
+    // Watches fire in batches on dispatch, not on the set path
+    {
+        std::vector<WatchEvent> seen;
+        size_t batches = 0;
+        auto subscriber = WatchTable::subscribe([&](const WatchEvent* events, size_t count) {
+            ++batches;
+            seen.insert(seen.end(), events, events + count);
+        });
+        auto watchA = ReflectionParser::watch(subscriber, "test_object.a");
+        assert(watchA != 0 && !ReflectionParser::watch(subscriber, "test_object.zz"));
+        assert(ReflectionParser::execute("watch test_object.d.b", result) == Status::NoSubscriber);
+        ReflectionParser::setWatchSubscriber(subscriber);
+        assert(ReflectionParser::execute("watch test_object.d.b", result) == Status::Ok);
+        std::string watchB = result;
+
+        ReflectionParser::parseAndExecute("set test_object.a=1");
+        ReflectionParser::parseAndExecute("set test_object.a=2");
+        ReflectionParser::set("test_record.b", std::string("watched"));
+        ReflectionParser::parseAndExecute("set test_object.d.a=3");
+        assert(seen.empty());
+        assert(WatchTable::dispatch() == 2 && batches == 1);
+        assert(seen[0].path == "test_object.a" && seen[0].value == "2");
+        assert(seen[1].path == "test_object.d.b" && seen[1].value == "watched");
+        assert(WatchTable::dispatch() == 0);
+
+        // A whole nested set reaches watches on the fields it names.
+        seen.clear();
+        assert(ReflectionParser::parseAndExecute("set test_object.d=a=3,b=whole") == "a=3,b=whole");
+        assert(WatchTable::dispatch() == 1 && seen.back().value == "whole");
+        assert(ReflectionParser::executeAs<A>("set test_object.d=b=watched", result) == Status::Ok);
+        assert(WatchTable::dispatch() == 1 && seen.back().value == "watched" && seen.size() == 2);
+
+        assert(ReflectionParser::execute("unwatch " + watchB, result) == Status::Ok);
+        assert(ReflectionParser::execute("unwatch " + watchB, result) == Status::WatchNotFound);
+        ReflectionParser::setWatchSubscriber(0);
+        WatchTable::unsubscribe(subscriber);
+        assert(active_watch_count == 0);
     }
 
-    static MemberMap reflect(T& obj) {
-        constexpr auto members = T::_reflect_members();
-        return reflect_impl(obj, members, 
-            std::make_index_sequence<std::tuple_size_v<decltype(members)>>{});
+    // Integer handles: "#<handle>" resolves without touching the id index
+    {
+        ObjectHandle handle = a.getHandle();
+        assert(handle != 0 && ObjectRegistry<A>::getObject(handle) == &a);
+        std::string byHandle = "#" + std::to_string(handle);
+        assert(ReflectionParser::parseAndExecute("get " + byHandle + ".d.a") == std::to_string(a.d.a));
+        auto compiled = ReflectionParser::compile(byHandle + ".a");
+        assert(compiled && compiled.get<int>() == a.a);
+        assert(ReflectionParser::parseAndExecute("set " + byHandle + ".a=41") == "41" && a.a == 41);
+        assert(ReflectionParser::execute("get #0.a", result) == Status::ObjectNotFound);
+        assert(ReflectionParser::execute("get #x1.a", result) == Status::ObjectNotFound);
+
+        // Freed slots go back to the free list of the object's address, so
+        // the next object there reuses the slot under a new generation.
+        std::optional<Record> holder;
+        holder.emplace("handle_temp");
+        ObjectHandle stale = holder->getHandle();
+        holder->registerAs("handle_temp2");
+        assert(holder->getHandle() == stale);
+        assert(ReflectionParser::compile("#" + std::to_string(stale) + ".a"));
+        holder.reset();
+        assert(!ObjectRegistry<Record>::getObject(stale));
+        Record& reuse = holder.emplace("handle_reuse");
+        assert(reuse.getHandle() != stale);
+        assert(static_cast<uint32_t>(reuse.getHandle()) == static_cast<uint32_t>(stale));
+        assert(!ObjectRegistry<Record>::getObject(stale));
+        holder.reset();
+
+        bool rejected = false;
+        try { Record bad("#1"); } catch (const std::invalid_argument&) { rejected = true; }
+        assert(rejected);
     }
-};
 
-// Generic reflection parser
-class ReflectionParser {
-private:
-    static std::vector<std::string> tokenize(const std::string& cmd) {
-        std::vector<std::string> tokens;
-        std::istringstream iss(cmd);
-        std::string token;
-        
-        while (std::getline(iss, token, ' ')) {
-            if (!token.empty()) {
-                tokens.push_back(token);
-            }
+    // Instrumentation: "stats" always parses; counts only when compiled in
+    {
+        assert(ReflectionParser::execute("stats", result) == Status::Ok);
+        assert(ReflectionParser::execute("stats bogus", result) == Status::InvalidCommand);
+        if constexpr (instrument::enabled) {
+            assert(ReflectionParser::execute("stats reset", result) == Status::Ok);
+            ReflectionParser::parseAndExecute("get test_object.d.a");
+            ReflectionParser::parseAndExecute("get missing_object.a");
+            ReflectionParser::parseAndExecute("get test_object.zz");
+            assert(ReflectionParser::execute("stats", result) == Status::Ok);
+            assert(result.find("lookup_hit=2 lookup_miss=1") != std::string::npos);
+            assert(result.find("member_hit=1 member_miss=1") != std::string::npos);
+            assert(result.find("\nparse n=4 ") != std::string::npos);  // this "stats" too
+        } else {
+            ReflectionParser::execute("stats", result);
+            assert(result == "instrumentation disabled");
         }
-        return tokens;
     }
 
-public:
-    static std::string parseAndExecute(const std::string& cmd) {
-        auto tokens = tokenize(cmd);
-        if (tokens.empty()) return "";
+    // Results formatted into caller buffers
+    {
+        char buffer[64];
+        size_t length = 0;
+        a.d.b = "buffered";
+        assert(ReflectionParser::execute("get test_object.d.b", buffer, sizeof(buffer), length) == Status::Ok);
+        assert(std::string_view(buffer, length) == "buffered");
+        assert(ReflectionParser::execute("set test_object.d.a=12345", buffer, sizeof(buffer), length) == Status::Ok);
+        assert(std::string_view(buffer, length) == "12345" && a.d.a == 12345);
+        assert(ReflectionParser::execute("get test_object.d.a", buffer, 4, length) == Status::BufferTooSmall);
+        assert(length == 0);
+        assert(ReflectionParser::execute("set test_object.d.a=777777", buffer, 4, length) == Status::BufferTooSmall);
+        assert(a.d.a == 12345);
+        assert(ReflectionParser::execute("dump test_record", buffer, sizeof(buffer), length) == Status::Ok);
+        assert(std::string_view(buffer, length) == "a=12345,b=buffered");
+        assert(ReflectionParser::execute("dump test_object", buffer, 8, length) == Status::BufferTooSmall);
+        assert(ReflectionParser::execute("get test_object.zz", buffer, sizeof(buffer), length) == Status::MemberNotFound);
+
+        // Results that do not fit leave no side effects behind.
+        ReflectionParser::parseAndExecute("delta test_object");
+        ReflectionParser::parseAndExecute("set test_object.a=61");
+        ReflectionParser::parseAndExecute("set test_record.b=buffered");
+        assert(ReflectionParser::execute("delta test_object", buffer, 4, length) == Status::BufferTooSmall);
+        assert(ReflectionParser::execute("delta test_object", buffer, sizeof(buffer), length) == Status::Ok);
+        assert(std::string_view(buffer, length) == "a=61,d.b=buffered");
+        {
+            // The undo restores the bits the delta took, whatever its text.
+            A holder("undo_holder");
+            ReflectionParser::parseAndExecute("delta undo_holder");
+            ReflectionParser::parseAndExecute("set undo_holder.d.b=p,a=9");
+            assert(ReflectionParser::execute("delta undo_holder", buffer, 4, length) == Status::BufferTooSmall);
+            assert(ReflectionParser::parseAndExecute("delta undo_holder") == "d.b=p\\,a=9");
+        }
 
-        std::string operation = tokens[0];
-        if (tokens.size() < 2) return "";
+        auto subscriber = WatchTable::subscribe(nullptr);
+        ReflectionParser::setWatchSubscriber(subscriber);
+        size_t watches = active_watch_count;
+        assert(ReflectionParser::execute("watch test_object.a", buffer, 0, length) == Status::BufferTooSmall);
+        assert(active_watch_count == watches);
+        ReflectionParser::setWatchSubscriber(0);
+        WatchTable::unsubscribe(subscriber);
+
+        assert(ReflectionParser::execute("stats reset", buffer, 1, length) == Status::BufferTooSmall);
+        if constexpr (instrument::enabled) {
+            assert(ReflectionParser::execute("stats", result) == Status::Ok);
+            assert(result.find("\nparse n=0 ") == std::string::npos);  // not reset
+        }
 
-        std::string pathSpec = tokens[1];
-        std::string value;
+        auto compiled = ReflectionParser::compile("test_object.d");
+        char* end = compiled.get(buffer, buffer + sizeof(buffer));
+        assert(end && std::string_view(buffer, end - buffer) == "a=12345,b=buffered");
+        assert(!compiled.get(buffer, buffer + 3));
+    }
 
-        if (operation == "set") {
-            size_t eqPos = pathSpec.find('=');
-            if (eqPos == std::string::npos) return "";
-            value = pathSpec.substr(eqPos + 1);
-            pathSpec = pathSpec.substr(0, eqPos);
+    // Worker pool: per-object order holds, results come back in submission order
+    {
+        std::vector<std::unique_ptr<Record>> records;
+        for (int i = 0; i < 8; ++i) {
+            records.push_back(std::make_unique<Record>("pool_" + std::to_string(i)));
         }
+        std::vector<std::string> script;
+        for (int i = 0; i < 2000; ++i) {
+            std::string id = "pool_" + std::to_string(i % 8);
+            script.push_back("set " + id + ".a=" + std::to_string(i));
+            script.push_back("get " + id + ".a");
+            if (i % 10 == 0) {
+                // Aliases: test_record is test_object.d, so both stay ordered.
+                script.push_back("set test_record.a=" + std::to_string(i));
+                script.push_back("get test_object.d.a");
+            }
+        }
+        script.push_back("set test_record.a=12345");
+        script.push_back("get pool_99.a");
+        std::vector<std::string_view> views(script.begin(), script.end());
+
+        BatchResult serial, parallel;
+        ReflectionParser::executeBatch(views.data(), views.size(), serial);
+        CommandPool pool(4);
+        pool.execute(views.data(), views.size(), parallel);
+        assert(parallel.size() == serial.size());
+        for (size_t i = 0; i < serial.size(); ++i) {
+            assert(parallel.status(i) == serial.status(i));
+            assert(parallel.value(i) == serial.value(i));
+        }
+        assert(parallel.value(3) == "0" && parallel.status(views.size() - 1) == Status::ObjectNotFound);
+        pool.execute(views.data(), 2, parallel);  // small batches stay serial
+        assert(parallel.size() == 2 && parallel.value(1) == "0");
+    }
 
-        size_t firstDot = pathSpec.find('.');
-        if (firstDot == std::string::npos) return "";
-
-        std::string objectId = pathSpec.substr(0, firstDot);
-        std::string memberPath = pathSpec.substr(firstDot + 1);
+    // Pattern queries over the registry
+    {
+        assert(glob_match("sensor_*", "sensor_12") && glob_match("s?n*_1*", "sensor_12"));
+        assert(!glob_match("sensor_*", "sensor") && glob_match("*", "") && !glob_match("a*b", "acbd"));
 
-        A* obj = ObjectRegistry<A>::getObject(objectId);
-        if (!obj) {
-            std::cerr << "Object not found: " << objectId << std::endl;
-            return "";
+        std::vector<std::unique_ptr<Record>> sensors;
+        for (int i = 0; i < 20; ++i) {
+            sensors.push_back(std::make_unique<Record>("sensor_" + std::to_string(i)));
+            sensors.back()->a = i;
         }
+        std::vector<std::unique_ptr<A>> owners;
+        owners.push_back(std::make_unique<A>("sensor_owner"));
+
+        assert(ReflectionParser::parseAndExecute("set sensor_1?.b=tuned") == "10");
+        assert(sensors[15]->b == "tuned" && sensors[5]->b.empty());
+
+        size_t visited = 0;
+        assert(ReflectionParser::query("sensor_*.b", [&](std::string_view, const BoundMember& m) {
+            visited += *m.as<std::string>() == "tuned";
+        }) == 20 && visited == 10);  // sensor_owner has no member b
+        assert(ReflectionParser::query("sensor_*.d.a", [](std::string_view, const BoundMember&) {}) == 1);
+
+        assert(ReflectionParser::execute("get sensor_?.a", result) == Status::Ok);
+        std::vector<std::string> lines;
+        for (size_t pos = 0; pos <= result.size();) {
+            size_t end = std::min(result.find('\n', pos), result.size());
+            lines.push_back(result.substr(pos, end - pos));
+            pos = end + 1;
+        }
+        std::sort(lines.begin(), lines.end());
+        assert(lines.size() == 10 && lines[0] == "sensor_0.a=0" && lines[9] == "sensor_9.a=9");
+
+        assert(ReflectionParser::execute("set sensor_*.a=bad", result) == Status::InvalidValue);
+        assert(ReflectionParser::execute("get nomatch_*.a", result) == Status::ObjectNotFound);
+        assert(ReflectionParser::execute("set sensor_*.zz=1", result) == Status::ObjectNotFound);
+        char buffer[32];
+        size_t length = 0;
+        assert(ReflectionParser::execute("set sensor_?.a=3", buffer, sizeof(buffer), length) == Status::Ok);
+        assert(std::string_view(buffer, length) == "10" && sensors[7]->a == 3 && sensors[17]->a == 17);
+        assert(ReflectionParser::execute("set sensor_*.a=42", buffer, 1, length) == Status::BufferTooSmall);
+        assert(sensors[0]->a == 3 && sensors[19]->a == 19);  // "20" does not fit: nothing applied
+    }
 
-        // Handle nested paths
-        size_t pos = memberPath.find('.');
-        if (pos != std::string::npos) {
-            std::string baseMember = memberPath.substr(0, pos);
-            std::string subPath = memberPath.substr(pos + 1);
-            
-            auto members = Reflector<A>::reflect(*obj);
-            auto it = members.find(baseMember);
-            if (it != members.end()) {
-                if (baseMember == "d") {
-                    return parseAndExecute(operation + " " + objectId + "." + subPath + 
-                        (operation == "set" ? "=" + value : ""));
-                }
-            }
-            return "";
+    // Compile-time dispatch: the same commands, specialized for a known type
+    {
+        static_assert(operation_from_token("unwatch") == Operation::Unwatch);
+        static_assert(!operation_from_token("gets") && !operation_from_token(""));
+
+        // Twins: one driven by the descriptor path, one by the typed path.
+        A generic("typed_generic"), typed("typed_static");
+        std::string expected;
+        for (std::string cmd : { "set $.a=41", "get $.a", "set $.d.b=typed", "get $.d.b",
+                                 "delta $", "delta $", "load $ a=2,d.a=3", "dump $", "get $.zz",
+                                 "get $.a.b", "set $.a=x", "get $.d", "get $.d.zz", "load $ a=5,zz=1",
+                                 "load $ a=x", "load $ a", "load $ d.a=7,d.b=typed", "bogus $" }) {
+            size_t at = cmd.find('$');
+            std::string forGeneric = cmd, forTyped = cmd;
+            forGeneric.replace(at, 1, "typed_generic");
+            forTyped.replace(at, 1, "typed_static");
+            Status status = ReflectionParser::execute(forGeneric, expected);
+            assert(ReflectionParser::executeAs<A>(forTyped, result) == status && result == expected);
         }
+        assert(typed.a == 5 && typed.d.a == 7 && typed.d.b == "typed");
+        assert(ReflectionParser::executeAs<A>("get typed_*.a", result) == Status::Ok);
+        assert(ReflectionParser::executeAs<A>("get missing_object.a", result) == Status::ObjectNotFound);
+
+        // Other types fall back to the descriptor path.
+        assert(ReflectionParser::executeAs<Record>("get typed_static.d.b", result) == Status::Ok &&
+               result == "typed");
+
+        size_t seen = npos_member;
+        assert(Reflector<A>::visit(typed, Reflector<A>::indexOf("d"), [&](auto member, auto& field) {
+            seen = decltype(member)::value;
+            if constexpr (std::is_same_v<std::decay_t<decltype(field)>, Record>) field.a = 99;
+        }));
+        assert(seen == 1 && typed.d.a == 99 && !Reflector<A>::visit(typed, 7, [](auto, auto&) {}));
+    }
 
-        auto members = Reflector<A>::reflect(*obj);
-        auto it = members.find(memberPath);
-        if (it == members.end()) {
-            std::cerr << "Member not found: " << memberPath << std::endl;
-            return "";
+    // Transactions: staged conversions, published together under seqlocks
+    {
+        A config("txn_object");
+        Transaction txn;
+        assert(txn.set("txn_object.a", "801") == Status::Ok);
+        assert(txn.set("txn_object.d.b", std::string("txn")) == Status::Ok);
+        assert(txn.set("txn_object.d.a", 802) == Status::Ok && txn.size() == 3);
+        assert(config.a == 1 && config.d.b == "hello");  // nothing applied before commit
+        ReflectionParser::parseAndExecute("delta txn_object");
+        assert(txn.commit() == Status::Ok && txn.size() == 0);
+        assert(config.a == 801 && config.d.a == 802 && config.d.b == "txn");
+        assert(ReflectionParser::parseAndExecute("delta txn_object") == "a=801,d.a=802,d.b=txn");
+
+        assert(txn.set("txn_object.d.b", "kept") == Status::Ok);
+        assert(txn.set("txn_object.a", "bad") == Status::InvalidValue);
+        assert(txn.set("missing.a", "1") == Status::ObjectNotFound);
+        assert(txn.set("txn_object.zz", "1") == Status::MemberNotFound);
+        assert(txn.set("txn_object.a", 1.5) == Status::InvalidValue);  // not exactly int
+        assert(txn.set("txn_object.d", "a=1,b=x") == Status::InvalidValue);  // whole Reflectable
+        assert(txn.commit() == Status::InvalidValue && config.d.b == "txn");  // all or nothing
+        txn.set("txn_object.d.b", "dropped");
+        txn.abort();
+        assert(txn.commit() == Status::Ok && config.d.b == "txn");
+        {
+            auto doomed = std::make_unique<A>("txn_doomed");
+            assert(txn.set("txn_doomed.d.a", 5) == Status::Ok && txn.set("txn_object.a", 7) == Status::Ok);
+            doomed.reset();  // gone between set() and commit()
+            assert(txn.commit() == Status::ObjectNotFound && config.a == 801 && txn.size() == 0);
         }
 
-        if (operation == "set") {
-            return it->second->setValue(value) ? value : "";
-        } else if (operation == "get") {
-            return it->second->getValue();
+        int outer = 0, inner = 0;
+        std::string text;
+        assert(ReflectionParser::read({ "txn_object.a", "txn_object.d.a" }, outer, inner) == Status::Ok);
+        assert(outer == 801 && inner == 802);
+        assert(ReflectionParser::read({ "txn_object.d.zz" }, outer) == Status::MemberNotFound);
+        assert(ReflectionParser::read({ "txn_object.d.b" }, outer) == Status::InvalidValue);
+
+        // Readers never see half of a commit, with or without strings involved.
+        txn.set("txn_object.a", 0);
+        txn.set("txn_object.d.a", 0);
+        assert(txn.commit() == Status::Ok);
+        std::atomic<bool> done{false};
+        std::thread writer([&] {
+            Transaction update;
+            for (int i = 0; i < 20000; ++i) {
+                update.set("txn_object.a", i);
+                update.set("txn_object.d.a", i % 16 == 0 ? i : -i);
+                if (i % 16 == 0) update.set("txn_object.d.b", std::to_string(i));
+                update.commit();
+            }
+            done.store(true);
+        });
+        size_t reads = 0;
+        while (!done.load() || reads < 1000) {
+            assert(ReflectionParser::read({ "txn_object.a", "txn_object.d.a" }, outer, inner) == Status::Ok);
+            assert(outer == -inner || (outer % 16 == 0 && outer == inner));
+            assert(ReflectionParser::read({ "txn_object.d.a", "txn_object.d.b" }, inner, text) == Status::Ok);
+            assert(inner <= 0 || text == std::to_string(inner));
+            ++reads;
         }
+        writer.join();
+    }
 
-        return "";
+    // Columnar storage: one contiguous vector per member, rows addressable by id
+    {
+        using Store = ReflectableColumnStore<Record>;
+        Store store;
+        store.reserve(1000);
+        for (int i = 0; i < 1000; ++i) store.column<Store::indexOf("a")>()[store.append()] = i;
+        assert(store.size() == 1000 && store.column<1>()[999].empty());
+        long sum = 0;
+        for (int value : store.column<Store::indexOf("a")>()) sum += value;
+        assert(sum == 999 * 1000 / 2);
+
+        store.registerRow(5, "col_5");
+        assert(ReflectionParser::parseAndExecute("get col_5.a") == "5");
+        assert(ReflectionParser::parseAndExecute("set col_5.b=columnar") == "columnar");
+        assert(store.column<1>()[5] == "columnar");
+        assert(ReflectionParser::parseAndExecute("dump col_5") == "a=5,b=columnar");
+        assert(ReflectionParser::compile("col_5.b").get<std::string>() == "columnar");
+        assert(*store.member(7, "a").as<int>() == 7 && !store.member(7, "zz"));
+        assert(ReflectionParser::execute("get col_5.d", result) == Status::MemberNotFound);
+
+        Record prototype("col_prototype");
+        prototype.a = 5;
+        prototype.b = "columnar";
+        std::string fromObject, fromRow;
+        BinaryCodec<Record>::encode(prototype, fromObject);
+        Store::type().encode(ObjectIndex::find("col_5").object, fromRow);
+        assert(fromRow == fromObject);
+
+        size_t copied = store.append(prototype);
+        store.registerRow(copied, "col_copy");
+        assert(ReflectionParser::parseAndExecute("set col_copy.a=77") == "77");
+        assert(Store::type().decode(fromRow, ObjectIndex::find("col_copy").object));
+        assert(store.column<0>()[copied] == 5 && store.column<1>()[copied] == "columnar");
     }
-};
+    {
+        // bool columns keep a byte per row, so each row has its own bool&.
+        ReflectableColumnStore<Switch> switches;
+        for (int i = 0; i < 4; ++i) switches.append();
+        switches.column<0>()[1] = true;
+        switches.registerRow(2, "switch_2");
+        assert(ReflectionParser::parseAndExecute("set switch_2.on=1") == "1");
+        bool* on = switches.member(2, "on").as<bool>();
+        assert(on && *on && switches.column<0>()[1] && !switches.column<0>()[3]);
+        assert(ReflectionParser::parseAndExecute("dump switch_2") == "on=1,level=0");
+    }
+    assert(ReflectionParser::execute("get col_5.a", result) == Status::ObjectNotFound);
 
-} // namespace reflection
+    // Command server: pipelined lines over TCP, answered in order
+    {
+        // A small read budget, so scripts arrive over several wakeups.
+        CommandServer::Options options;
+        options.maxReadPerWakeup = 64;
+        CommandServer server(options);
+        assert(server.start() && server.port() != 0);
+        std::thread loop([&server] { server.run(); });
+
+        auto connect = [&server] {
+            int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(server.port());
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            assert(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+            return fd;
+        };
+        auto readAll = [](int fd) {
+            std::string received;
+            char chunk[4096];
+            for (ssize_t n; (n = ::read(fd, chunk, sizeof(chunk))) > 0;) received.append(chunk, n);
+            ::close(fd);
+            return received;
+        };
+
+        int fd = connect();
+        std::string script = "set test_object.a=5\nget test_object.a\r\nbogus x\n"
+                             "get test_object.zz\nset test_record.b=served\ndump test_record\nget test";
+        assert(::write(fd, script.data(), script.size()) == static_cast<ssize_t>(script.size()));
+        ::shutdown(fd, SHUT_WR);
+        assert(readAll(fd) == "+1\n5\n+1\n5\n-unknown_operation\n-member_not_found\n"
+                              "+6\nserved\n+16\na=12345,b=served\n");
+
+        // Watches cannot deliver over this transport and are rejected in order.
+        size_t watches = active_watch_count;
+        fd = connect();
+        script = "get test_object.a\nwatch test_object.a\n  watch test_record.b\nget test_record.b\n";
+        assert(::write(fd, script.data(), script.size()) == static_cast<ssize_t>(script.size()));
+        ::shutdown(fd, SHUT_WR);
+        assert(readAll(fd) == "+1\n5\n-no_subscriber\n-no_subscriber\n+6\nserved\n");
+        assert(active_watch_count == watches);
+
+        // Enough responses to fill the socket, so some go out on EPOLLOUT.
+        fd = connect();
+        std::thread writer([fd] {
+            std::string many;
+            for (int i = 0; i < 50000; ++i) many += "dump test_record\n";
+            for (size_t sent = 0; sent < many.size();) {
+                ssize_t n = ::write(fd, many.data() + sent, many.size() - sent);
+                assert(n > 0);
+                sent += n;
+            }
+            ::shutdown(fd, SHUT_WR);
+        });
+        std::string received = readAll(fd);
+        writer.join();
+        assert(received.size() == 50000 * std::string("+16\na=12345,b=served\n").size());
+
+        server.stop();
+        loop.join();
+        assert(a.a == 5 && a.d.b == "served");
+    }
 
-int main() {
-    using namespace reflection;
-    
-    A a("test_object");
-    
-    // Basic get/set for direct members
-    assert(ReflectionParser::parseAndExecute("set test_object.a=42") == "42");
-    assert(ReflectionParser::parseAndExecute("get test_object.a") == "42");
-    
-    // Nested member access
-    assert(ReflectionParser::parseAndExecute("set test_object.d.a=666") == "666");
-    assert(ReflectionParser::parseAndExecute("get test_object.d.a") == "666");
-    
-    // String member tests
-    assert(ReflectionParser::parseAndExecute("set test_object.d.b=hello_world") == "hello_world");
-    assert(ReflectionParser::parseAndExecute("get test_object.d.b") == "hello_world");
-    
     // Error cases
     assert(ReflectionParser::parseAndExecute("set invalid_object.a=42").empty()); // Invalid object
     assert(ReflectionParser::parseAndExecute("set test_object.invalid=42").empty()); // Invalid member
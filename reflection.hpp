@@ -0,0 +1,4148 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <condition_variable>
+#include <charconv>
+#include <limits>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <array>
+#include <tuple>
+#include <utility>
+#include <cassert>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include <boost/lexical_cast.hpp>
+
+// Build with -DREFLECTION_INSTRUMENT=1 to time parser stages (see the
+// instrument namespace); otherwise the hooks compile to nothing.
+#ifndef REFLECTION_INSTRUMENT
+#define REFLECTION_INSTRUMENT 0
+#endif
+
+namespace reflection {
+
+// Move these helper traits before TypeTraits
+template<typename T, typename = void>
+struct is_lexical_castable {
+private:
+    template<typename U>
+    static auto test(int) -> decltype(
+        boost::lexical_cast<U>(std::string()),
+        boost::lexical_cast<std::string>(std::declval<U>()),
+        std::true_type()
+    );
+
+    template<typename>
+    static auto test(...) -> std::false_type;
+
+public:
+    static constexpr bool value = 
+        !std::is_same_v<T, void> && 
+        std::is_default_constructible_v<T> &&
+        decltype(test<T>(0))::value;
+};
+
+template<typename T>
+inline constexpr bool is_lexical_castable_v = is_lexical_castable<T>::value;
+
+// Now TypeTraits can use is_lexical_castable_v
+template<typename T, typename = void>
+struct TypeTraits {
+    // Non-throwing conversion; out is unspecified when it returns false.
+    static bool tryFromString(std::string_view str, T& out) {
+        static_assert(is_lexical_castable_v<T>, 
+            "Type must either support lexical_cast or have custom TypeTraits specialization");
+        return boost::conversion::try_lexical_convert(str.data(), str.size(), out);
+    }
+
+    static T fromString(std::string_view str) {
+        static_assert(is_lexical_castable_v<T>, 
+            "Type must either support lexical_cast or have custom TypeTraits specialization");
+        return boost::lexical_cast<T>(str.data(), str.size());
+    }
+    
+    static std::string toString(const T& val) {
+        static_assert(is_lexical_castable_v<T>, 
+            "Type must either support lexical_cast or have custom TypeTraits specialization");
+        return boost::lexical_cast<std::string>(val);
+    }
+};
+
+// Character types keep lexical_cast semantics (a single character, not a
+// number), so only the remaining arithmetic types take the charconv path.
+template<typename T>
+inline constexpr bool is_charconv_type_v =
+    std::is_arithmetic_v<T> && !std::is_same_v<T, bool> &&
+    !std::is_same_v<T, char> && !std::is_same_v<T, signed char> &&
+    !std::is_same_v<T, unsigned char> && !std::is_same_v<T, wchar_t> &&
+    !std::is_same_v<T, char16_t> && !std::is_same_v<T, char32_t>;
+
+// Arithmetic types: std::to_chars/std::from_chars, no streams or allocation.
+// toChars writes into [first, last) and returns the end of the text, or
+// nullptr if the buffer is too small; max_chars always fits.
+template<typename T>
+struct TypeTraits<T, std::enable_if_t<is_charconv_type_v<T>>> {
+    static constexpr size_t max_chars = std::is_integral_v<T>
+        ? std::numeric_limits<T>::digits10 + 3
+        : std::numeric_limits<T>::max_digits10 + 10;
+
+    static char* toChars(char* first, char* last, T val) {
+        auto [ptr, ec] = std::to_chars(first, last, val);
+        return ec == std::errc() ? ptr : nullptr;
+    }
+
+    static bool tryFromString(std::string_view str, T& out) {
+        // from_chars rejects the leading '+' that lexical_cast accepted.
+        if (str.size() > 1 && str.front() == '+' && str[1] != '-') {
+            str.remove_prefix(1);
+        }
+        auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), out);
+        return ec == std::errc() && ptr == str.data() + str.size();
+    }
+
+    static T fromString(std::string_view str) {
+        T val{};
+        if (!tryFromString(str, val)) {
+            throw boost::bad_lexical_cast(typeid(std::string), typeid(T));
+        }
+        return val;
+    }
+
+    static std::string toString(T val) {
+        char buf[max_chars];
+        return std::string(buf, toChars(buf, buf + max_chars, val));
+    }
+};
+
+// bool keeps lexical_cast's "0"/"1" text form.
+template<>
+struct TypeTraits<bool> {
+    static constexpr size_t max_chars = 1;
+
+    static char* toChars(char* first, char* last, bool val) {
+        if (first == last) return nullptr;
+        *first = val ? '1' : '0';
+        return first + 1;
+    }
+
+    static bool tryFromString(std::string_view str, bool& out) {
+        if (str != "1" && str != "0") return false;
+        out = str == "1";
+        return true;
+    }
+
+    static bool fromString(std::string_view str) {
+        bool val = false;
+        if (!tryFromString(str, val)) {
+            throw boost::bad_lexical_cast(typeid(std::string), typeid(bool));
+        }
+        return val;
+    }
+
+    static std::string toString(bool val) {
+        return val ? "1" : "0";
+    }
+};
+
+// Forward declarations
+template<typename T>
+struct Reflector;
+
+// Forward declarations
+template<typename Derived>
+class Reflectable;
+
+template<typename T>
+inline constexpr bool is_reflectable_v = std::is_base_of_v<Reflectable<T>, T>;
+
+struct TypeDescriptor;
+
+// Identity of a C++ type without RTTI: the address of a per-type tag.
+using TypeId = const void*;
+
+template<typename T>
+struct TypeIdTag {
+    static constexpr char tag = 0;
+};
+
+template<typename T>
+constexpr TypeId type_id() {
+    return &TypeIdTag<std::remove_cv_t<T>>::tag;
+}
+
+// A member value held apart from any object, for Transaction: text is
+// converted into a detached heap value first, and moved into the member
+// when the transaction commits.
+struct ValueOps {
+    void* (*parse)(std::string_view text);      // new value, or null if rejected
+    void (*assign)(void* target, void* value);  // moves value into target
+    void (*destroy)(void* value);
+};
+
+// Type-erased accessors for one reflected member. The object is passed as
+// void* so that a descriptor can live in a static table shared by every
+// instance; the pointer-to-member is baked into the instantiation.
+struct MemberDescriptor {
+    const char* name;
+    size_t index;  // position in the owning type's member table
+    TypeId type;
+    std::string (*getValue)(const void* object);
+    void (*appendValue)(const void* object, std::string& out);
+    // Formats into [first, last); the end of the text, or null if it does not fit.
+    char* (*writeValue)(const void* object, char* first, char* last);
+    bool (*setValue)(void* object, std::string_view value);
+    void* (*address)(void* object);
+    // Member table of the member's own type if it is Reflectable, else null.
+    const TypeDescriptor* nested;
+    // Detached values of the member's type; null for Reflectable members,
+    // which convert in place and cannot be staged whole.
+    const ValueOps* ops;
+};
+
+// Whether TypeTraits<T>::fromString can take a string_view directly;
+// hand-written specializations taking const std::string& need a copy.
+template<typename T, typename = void>
+struct has_view_from_string : std::false_type {};
+
+template<typename T>
+struct has_view_from_string<T, std::void_t<
+    decltype(TypeTraits<T>::fromString(std::declval<std::string_view>()))>>
+    : std::true_type {};
+
+template<typename T>
+inline constexpr bool has_view_from_string_v = has_view_from_string<T>::value;
+
+// Whether TypeTraits<T> provides the non-throwing tryFromString contract;
+// specializations that only offer fromString are called under try/catch.
+template<typename T, typename = void>
+struct has_try_from_string : std::false_type {};
+
+template<typename T>
+struct has_try_from_string<T, std::void_t<decltype(TypeTraits<T>::tryFromString(
+    std::declval<std::string_view>(), std::declval<T&>()))>>
+    : std::true_type {};
+
+template<typename T>
+inline constexpr bool has_try_from_string_v = has_try_from_string<T>::value;
+
+// Whether TypeTraits<T> can format into a caller buffer (see toChars).
+template<typename T, typename = void>
+struct has_to_chars : std::false_type {};
+
+template<typename T>
+struct has_to_chars<T, std::void_t<decltype(TypeTraits<T>::toChars(
+    std::declval<char*>(), std::declval<char*>(), std::declval<const T&>()))>>
+    : std::true_type {};
+
+template<typename T>
+inline constexpr bool has_to_chars_v = has_to_chars<T>::value;
+
+// Appends the text form of val to out, formatting in place when possible.
+template<typename T>
+void append_value(std::string& out, const T& val) {
+    if constexpr (is_reflectable_v<T>) {
+        TypeTraits<T>::append(out, val);
+    } else if constexpr (has_to_chars_v<T>) {
+        size_t size = out.size();
+        out.resize(size + TypeTraits<T>::max_chars);
+        char* end = TypeTraits<T>::toChars(&out[size], &out[size] + TypeTraits<T>::max_chars, val);
+        out.resize(end - out.data());
+    } else {
+        out += TypeTraits<T>::toString(val);
+    }
+}
+
+// Writes the text form of val into [first, last) and returns its end, or
+// nullptr if it does not fit. Types without toChars are formatted into a
+// per-thread scratch string first, which stops allocating once it has grown.
+template<typename T>
+char* write_value(char* first, char* last, const T& val) {
+    if constexpr (has_to_chars_v<T>) {
+        return TypeTraits<T>::toChars(first, last, val);
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        if (val.size() > static_cast<size_t>(last - first)) return nullptr;
+        return std::copy(val.begin(), val.end(), first);
+    } else {
+        thread_local std::string scratch;
+        scratch.clear();
+        append_value(scratch, val);
+        if (scratch.size() > static_cast<size_t>(last - first)) return nullptr;
+        return std::copy(scratch.begin(), scratch.end(), first);
+    }
+}
+
+// Sets every "path=value" field of payload on object, or none of them.
+bool assign_fields(const TypeDescriptor& type, void* object, std::string_view payload);
+
+// Converts value into target through TypeTraits. Returns false and leaves
+// target unchanged if the text is rejected.
+template<typename T>
+bool assign_from_string(T& target, std::string_view value) {
+    if constexpr (is_reflectable_v<T>) {
+        // Applied in place, so fields not named keep their values and the
+        // named ones go through their own change bits and watches.
+        return assign_fields(Reflector<T>::type, &target, value);
+    } else if constexpr (has_try_from_string_v<T>) {
+        // Convert into a temporary so a rejected value leaves the member intact.
+        T parsed{};
+        if (!TypeTraits<T>::tryFromString(value, parsed)) return false;
+        target = std::move(parsed);
+        return true;
+    } else {
+        try {
+            if constexpr (has_view_from_string_v<T>) {
+                target = TypeTraits<T>::fromString(value);
+            } else {
+                target = TypeTraits<T>::fromString(std::string(value));
+            }
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+}
+
+// Base class for member info
+class MemberInfoBase {
+public:
+    virtual ~MemberInfoBase() = default;
+    virtual std::string getValue() const = 0;
+    virtual bool setValue(const std::string& value) = 0;
+};
+
+// Templated member info implementation
+template<typename T>
+class MemberInfo : public MemberInfoBase {
+    T* member;
+public:
+    explicit MemberInfo(T* ptr) : member(ptr) {}
+
+    std::string getValue() const override {
+        return TypeTraits<T>::toString(*member);
+    }
+
+    bool setValue(const std::string& value) override {
+        return assign_from_string(*member, value);
+    }
+};
+
+template<typename T, typename MemberInfoT>
+struct MemberAccessor {
+    using Type = typename MemberInfoT::type;
+
+    static const Type& ref(const void* object) {
+        return static_cast<const T*>(object)->*(MemberInfoT::template pointer<T>());
+    }
+
+    static Type& ref(void* object) {
+        return static_cast<T*>(object)->*(MemberInfoT::template pointer<T>());
+    }
+
+    static std::string getValue(const void* object) {
+        return TypeTraits<Type>::toString(ref(object));
+    }
+
+    static void appendValue(const void* object, std::string& out) {
+        append_value(out, ref(object));
+    }
+
+    static char* writeValue(const void* object, char* first, char* last) {
+        return write_value(first, last, ref(object));
+    }
+
+    static void* address(void* object) {
+        return &ref(object);
+    }
+
+    static bool setValue(void* object, std::string_view value) {
+        return assign_from_string(ref(object), value);
+    }
+};
+
+// Copies a trivially copyable value with word-sized atomic stores (publish)
+// or loads (observe), so a Transaction commit and a sequence-checked read
+// of the same member may overlap; the sequence check discards torn copies.
+namespace seq_copy {
+
+typedef uint64_t __attribute__((may_alias)) Word64;
+typedef uint32_t __attribute__((may_alias)) Word32;
+
+template<bool Publish>
+inline void copy(void* target, const void* source, size_t size) {
+    auto* out = static_cast<unsigned char*>(target);
+    auto* in = static_cast<const unsigned char*>(source);
+    const unsigned char* shared = Publish ? out : in;
+    constexpr int order = Publish ? __ATOMIC_RELEASE : __ATOMIC_ACQUIRE;
+    for (size_t i = 0; i < size;) {
+        uintptr_t at = reinterpret_cast<uintptr_t>(shared + i);
+        if (size - i >= 8 && at % 8 == 0) {
+            if (Publish) {
+                Word64 word;
+                std::memcpy(&word, in + i, 8);
+                __atomic_store_n(reinterpret_cast<Word64*>(out + i), word, order);
+            } else {
+                Word64 word = __atomic_load_n(reinterpret_cast<const Word64*>(in + i), order);
+                std::memcpy(out + i, &word, 8);
+            }
+            i += 8;
+        } else if (size - i >= 4 && at % 4 == 0) {
+            if (Publish) {
+                Word32 word;
+                std::memcpy(&word, in + i, 4);
+                __atomic_store_n(reinterpret_cast<Word32*>(out + i), word, order);
+            } else {
+                Word32 word = __atomic_load_n(reinterpret_cast<const Word32*>(in + i), order);
+                std::memcpy(out + i, &word, 4);
+            }
+            i += 4;
+        } else {
+            if (Publish) {
+                __atomic_store_n(out + i, in[i], order);
+            } else {
+                out[i] = __atomic_load_n(in + i, order);
+            }
+            ++i;
+        }
+    }
+}
+
+inline void publish(void* target, const void* source, size_t size) { copy<true>(target, source, size); }
+inline void observe(void* target, const void* source, size_t size) { copy<false>(target, source, size); }
+
+} // namespace seq_copy
+
+template<typename T>
+struct StagedValue {
+    static void* parse(std::string_view text) {
+        auto value = std::make_unique<T>();
+        return assign_from_string(*value, text) ? value.release() : nullptr;
+    }
+
+    static void assign(void* target, void* value) {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            seq_copy::publish(target, value, sizeof(T));
+        } else {
+            *static_cast<T*>(target) = std::move(*static_cast<T*>(value));
+        }
+    }
+
+    static void destroy(void* value) { delete static_cast<T*>(value); }
+
+    static constexpr ValueOps ops = { &parse, &assign, &destroy };
+};
+
+// Staging operations for members of type T, or null if T is Reflectable.
+template<typename T>
+constexpr const ValueOps* value_ops() {
+    if constexpr (is_reflectable_v<T>) {
+        return nullptr;
+    } else {
+        return &StagedValue<T>::ops;
+    }
+}
+
+template<typename T, typename MemberInfoT, size_t Index>
+constexpr MemberDescriptor make_descriptor() {
+    using Accessor = MemberAccessor<T, MemberInfoT>;
+    using Type = typename MemberInfoT::type;
+    const TypeDescriptor* nested = nullptr;
+    if constexpr (is_reflectable_v<Type>) {
+        nested = &Reflector<Type>::type;
+    }
+    return { MemberInfoT::name, Index, type_id<Type>(), &Accessor::getValue,
+             &Accessor::appendValue, &Accessor::writeValue, &Accessor::setValue,
+             &Accessor::address, nested, value_ops<Type>() };
+}
+
+// Name -> member index entry. Reflector<T> keeps these sorted by name so a
+// lookup is a constexpr binary search over string_views.
+struct MemberIndexEntry {
+    std::string_view name;
+    size_t index;
+};
+
+inline constexpr size_t npos_member = static_cast<size_t>(-1);
+
+template<size_t N>
+constexpr std::array<MemberIndexEntry, N> sort_member_index(std::array<MemberIndexEntry, N> entries) {
+    for (size_t i = 1; i < N; ++i) {
+        MemberIndexEntry key = entries[i];
+        size_t j = i;
+        for (; j > 0 && key.name < entries[j - 1].name; --j) {
+            entries[j] = entries[j - 1];
+        }
+        entries[j] = key;
+    }
+    return entries;
+}
+
+constexpr size_t find_member_index(const MemberIndexEntry* entries, size_t count,
+                                   std::string_view name) {
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int cmp = entries[mid].name.compare(name);
+        if (cmp == 0) return entries[mid].index;
+        if (cmp < 0) lo = mid + 1; else hi = mid;
+    }
+    return npos_member;
+}
+
+// Dirty bits for the reflected members of one object: bit i stands for
+// member i. Types opt in with REFLECT_TRACK_CHANGES(); reflective sets and
+// the generated set_<member>() setters mark bits, and take() hands them to
+// the caller while clearing them.
+class ChangeTracker {
+    std::atomic<uint64_t> bits{0};
+public:
+    ChangeTracker() = default;
+    ChangeTracker(const ChangeTracker& other) : bits(other.peek()) {}
+    ChangeTracker& operator=(const ChangeTracker& other) {
+        bits.store(other.peek(), std::memory_order_relaxed);
+        return *this;
+    }
+
+    void mark(size_t index) { bits.fetch_or(uint64_t(1) << index, std::memory_order_relaxed); }
+    uint64_t peek() const { return bits.load(std::memory_order_relaxed); }
+    uint64_t take() { return bits.exchange(0, std::memory_order_acq_rel); }
+    // Sets bits again, for changes taken by a delta that was not delivered.
+    void restore(uint64_t mask) { bits.fetch_or(mask, std::memory_order_relaxed); }
+};
+
+// The bits one delta took, per tracker, so that they can be put back.
+using TakenChanges = std::vector<std::pair<ChangeTracker*, uint64_t>>;
+
+#define REFLECT_TRACK_CHANGES() ::reflection::ChangeTracker _reflect_changes;
+
+template<typename T, typename = void>
+struct has_change_tracker : std::false_type {};
+
+template<typename T>
+struct has_change_tracker<T, std::void_t<decltype(std::declval<T&>()._reflect_changes)>>
+    : std::true_type {};
+
+template<typename T>
+inline constexpr bool has_change_tracker_v = has_change_tracker<T>::value;
+
+// Member table of one reflected type, in type-erased form so that paths can
+// be walked across types without templates.
+struct TypeDescriptor {
+    const MemberDescriptor* members;
+    const MemberIndexEntry* index;
+    size_t member_count;
+    // Appends every reflected field as "path=value" pairs (see Reflector::dump).
+    void (*dump)(const void* object, std::string& out);
+    // sizeof the type and its BinaryCodec entry points.
+    size_t size;
+    void (*encode)(const void* object, std::string& out);
+    bool (*decode)(std::string_view in, void* object);
+    // The object's ChangeTracker, or null for types that do not track.
+    ChangeTracker* (*changes)(void* object);
+    // Appends changed fields since the last call (see Reflector::collectChanges),
+    // recording the bits it takes in taken unless that is null.
+    void (*delta)(void* object, std::string& out, TakenChanges* taken);
+
+    constexpr size_t indexOf(std::string_view name) const {
+        return find_member_index(index, member_count, name);
+    }
+};
+
+// Number of live watches (see WatchTable). Reflective sets check it before
+// doing any watch bookkeeping, so with no watchers the cost is one branch.
+inline std::atomic<size_t> active_watch_count{0};
+
+// Queues notifications for watches on member `index` of object.
+void notify_watchers(const void* object, size_t index);
+
+// A member descriptor bound to a concrete object; cheap to copy.
+// Sets through it mark the change bit of the innermost tracked object on
+// the path that led here and notify watchers of the member; writes through
+// as<T>() are neither tracked nor watched.
+class BoundMember {
+    friend class Transaction;
+    friend bool assign_fields(const TypeDescriptor&, void*, std::string_view);
+
+    const MemberDescriptor* descriptor = nullptr;
+    void* object = nullptr;
+    ChangeTracker* tracker = nullptr;
+    size_t changeBit = 0;
+
+    void onSet() const {
+        if (tracker) tracker->mark(changeBit);
+        if (active_watch_count.load(std::memory_order_relaxed) != 0) {
+            notify_watchers(object, descriptor->index);
+        }
+    }
+
+public:
+    BoundMember() = default;
+    BoundMember(const MemberDescriptor* desc, void* obj,
+                ChangeTracker* changes = nullptr, size_t bit = 0)
+        : descriptor(desc), object(obj), tracker(changes), changeBit(bit) {}
+
+    explicit operator bool() const { return descriptor != nullptr; }
+    const char* name() const { return descriptor->name; }
+    // The object that directly owns the member, and the member's index in it.
+    void* owner() const { return object; }
+    size_t index() const { return descriptor->index; }
+
+    std::string getValue() const { return descriptor->getValue(object); }
+    void appendValue(std::string& out) const { descriptor->appendValue(object, out); }
+    char* writeValue(char* first, char* last) const {
+        return descriptor->writeValue(object, first, last);
+    }
+    bool setValue(std::string_view value) const {
+        if (!descriptor->setValue(object, value)) return false;
+        onSet();
+        return true;
+    }
+
+    // Direct typed access, bypassing TypeTraits; null/false on type mismatch.
+    template<typename T>
+    T* as() const {
+        return descriptor->type == type_id<T>()
+            ? static_cast<T*>(descriptor->address(object)) : nullptr;
+    }
+
+    template<typename T>
+    bool set(T&& value) const {
+        auto* target = as<std::decay_t<T>>();
+        if (!target) return false;
+        *target = std::forward<T>(value);
+        onSet();
+        return true;
+    }
+};
+
+// Outcome of executing one command.
+enum class Status {
+    Ok,
+    InvalidCommand,     // malformed command text
+    UnknownOperation,
+    ObjectNotFound,
+    MemberNotFound,
+    InvalidValue,       // value rejected by TypeTraits
+    NoSubscriber,       // "watch" without a subscriber to deliver to
+    WatchNotFound,
+    BufferTooSmall,     // result does not fit the caller's buffer
+};
+
+inline const char* statusName(Status status) {
+    switch (status) {
+        case Status::Ok: return "ok";
+        case Status::InvalidCommand: return "invalid_command";
+        case Status::UnknownOperation: return "unknown_operation";
+        case Status::ObjectNotFound: return "object_not_found";
+        case Status::MemberNotFound: return "member_not_found";
+        case Status::InvalidValue: return "invalid_value";
+        case Status::NoSubscriber: return "no_subscriber";
+        case Status::WatchNotFound: return "watch_not_found";
+        case Status::BufferTooSmall: return "buffer_too_small";
+    }
+    return "unknown";
+}
+
+enum class Operation { Get, Set, Dump, Load, Delta, Watch, Unwatch, Stats };
+
+// Operation named by a command's first token, or nothing. Decided once per
+// command, by length first, so later stages switch on the enum instead of
+// comparing strings.
+constexpr std::optional<Operation> operation_from_token(std::string_view token) {
+    switch (token.size()) {
+        case 3:
+            if (token == "get") return Operation::Get;
+            if (token == "set") return Operation::Set;
+            break;
+        case 4:
+            if (token == "dump") return Operation::Dump;
+            if (token == "load") return Operation::Load;
+            break;
+        case 5:
+            if (token == "delta") return Operation::Delta;
+            if (token == "watch") return Operation::Watch;
+            if (token == "stats") return Operation::Stats;
+            break;
+        case 7:
+            if (token == "unwatch") return Operation::Unwatch;
+            break;
+    }
+    return std::nullopt;
+}
+
+// Resolves a dotted member path such as "d.a" against object, descending
+// one segment at a time through nested Reflectable members.
+inline BoundMember resolve_path(const TypeDescriptor& root, void* object, std::string_view path) {
+    const TypeDescriptor* type = &root;
+    ChangeTracker* tracker = nullptr;
+    size_t changeBit = 0;
+    for (;;) {
+        size_t dot = path.find('.');
+        size_t index = type->indexOf(path.substr(0, dot));
+        if (index == npos_member) return BoundMember();
+
+        if (type->changes) {
+            tracker = type->changes(object);
+            changeBit = index;
+        }
+        const MemberDescriptor& member = type->members[index];
+        if (dot == std::string_view::npos) return BoundMember(&member, object, tracker, changeBit);
+        if (!member.nested) return BoundMember();
+
+        object = member.address(object);
+        type = member.nested;
+        path.remove_prefix(dot + 1);
+    }
+}
+
+// A member path resolved against a type once, as member indices, so it can
+// be bound to any object of that type without looking names up again.
+class MemberPath {
+public:
+    MemberPath() = default;
+
+    // Invalid if path does not name a member of root.
+    static MemberPath resolve(const TypeDescriptor& root, std::string_view path) {
+        MemberPath resolved;
+        const TypeDescriptor* type = &root;
+        for (;;) {
+            size_t dot = path.find('.');
+            size_t index = type->indexOf(path.substr(0, dot));
+            if (index == npos_member) return MemberPath();
+            resolved.steps.push_back(index);
+            const MemberDescriptor& member = type->members[index];
+            if (dot == std::string_view::npos) break;
+            if (!member.nested) return MemberPath();
+            type = member.nested;
+            path.remove_prefix(dot + 1);
+        }
+        resolved.root = &root;
+        return resolved;
+    }
+
+    explicit operator bool() const { return root != nullptr; }
+    const TypeDescriptor* type() const { return root; }
+
+    // Same result as resolve_path(type(), object, path).
+    BoundMember bind(void* object) const {
+        const TypeDescriptor* type = root;
+        ChangeTracker* tracker = nullptr;
+        size_t changeBit = 0;
+        for (size_t i = 0;; ++i) {
+            if (type->changes) {
+                tracker = type->changes(object);
+                changeBit = steps[i];
+            }
+            const MemberDescriptor& member = type->members[steps[i]];
+            if (i + 1 == steps.size()) return BoundMember(&member, object, tracker, changeBit);
+            object = member.address(object);
+            type = member.nested;
+        }
+    }
+
+private:
+    const TypeDescriptor* root = nullptr;
+    std::vector<size_t> steps;
+};
+
+// Whether an object id is a glob pattern: '*' matches any run of
+// characters and '?' any single one.
+inline bool is_pattern(std::string_view id) {
+    return id.find_first_of("*?") != std::string_view::npos;
+}
+
+inline bool glob_match(std::string_view pattern, std::string_view text) {
+    size_t p = 0, t = 0, star = std::string_view::npos, resume = 0;
+    while (t < text.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+            ++p;
+            ++t;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            resume = t;
+        } else if (star != std::string_view::npos) {
+            // Let the last '*' absorb one more character and retry.
+            p = star + 1;
+            t = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') ++p;
+    return p == pattern.size();
+}
+
+// Values in the dump format escape ',', ' ' and '\\' with a '\\', so any
+// value survives a dump and a load.
+constexpr bool is_field_special(char c) { return c == ',' || c == ' ' || c == '\\'; }
+
+// Escapes the value appended to out since start, in place.
+inline void escape_field_value(std::string& out, size_t start) {
+    size_t specials = std::count_if(out.begin() + start, out.end(), is_field_special);
+    if (specials == 0) return;
+    size_t from = out.size();
+    out.resize(from + specials);
+    for (size_t to = out.size(); from > start;) {
+        char c = out[--from];
+        out[--to] = c;
+        if (is_field_special(c)) out[--to] = '\\';
+    }
+}
+
+// Calls fn(path, value) for every "path=value" field of a dump-format
+// payload, with the value unescaped, until fn returns anything but Ok.
+// Returns that status, or InvalidCommand for a field without '='.
+template<typename Fn>
+Status for_each_field(std::string_view payload, Fn&& fn) {
+    std::string unescaped;
+    size_t pos = 0;
+    while (pos < payload.size()) {
+        size_t end = pos;
+        while (end < payload.size() && payload[end] != ',') end += payload[end] == '\\' ? 2 : 1;
+        end = std::min(end, payload.size());
+        std::string_view field = payload.substr(pos, end - pos);
+        pos = end + 1;
+
+        size_t eqPos = field.find('=');
+        if (eqPos == std::string_view::npos) return Status::InvalidCommand;
+        std::string_view value = field.substr(eqPos + 1);
+        if (value.find('\\') != std::string_view::npos) {
+            unescaped.clear();
+            for (size_t i = 0; i < value.size(); ++i) {
+                if (value[i] == '\\' && i + 1 < value.size()) ++i;
+                unescaped += value[i];
+            }
+            value = unescaped;
+        }
+        Status status = fn(field.substr(0, eqPos), value);
+        if (status != Status::Ok) return status;
+    }
+    return Status::Ok;
+}
+
+// Applies "path=value" pairs separated by ',' (the Reflector::dump format)
+// to object, in place. Stops at the first field that fails, leaving the
+// fields before it applied.
+inline Status load_fields(const TypeDescriptor& type, void* object, std::string_view payload) {
+    return for_each_field(payload, [&](std::string_view path, std::string_view value) {
+        BoundMember member = resolve_path(type, object, path);
+        if (!member) return Status::MemberNotFound;
+        return member.setValue(value) ? Status::Ok : Status::InvalidValue;
+    });
+}
+
+// Converts every field into a detached value (see ValueOps) before moving
+// any of them in, so a field rejected late leaves object untouched. Fields
+// must name members that are not Reflectable themselves, as in the dump
+// format. The sets then run through BoundMember's hooks like setValue().
+inline bool assign_fields(const TypeDescriptor& type, void* object, std::string_view payload) {
+    struct Parsed {
+        BoundMember member;
+        void* value;
+    };
+    std::vector<Parsed> parsed;
+    bool ok = for_each_field(payload, [&](std::string_view path, std::string_view text) {
+        BoundMember member = resolve_path(type, object, path);
+        void* value = member && member.descriptor->ops ? member.descriptor->ops->parse(text) : nullptr;
+        if (!value) return Status::InvalidValue;
+        parsed.push_back({ member, value });
+        return Status::Ok;
+    }) == Status::Ok;
+    for (const Parsed& field : parsed) {
+        const MemberDescriptor* descriptor = field.member.descriptor;
+        if (ok) {
+            descriptor->ops->assign(descriptor->address(field.member.object), field.value);
+            field.member.onSet();
+        }
+        descriptor->ops->destroy(field.value);
+    }
+    return ok;
+}
+
+// Reflectable types convert through their member list, in the dump format.
+// Decoding works in place on an existing object; there is deliberately no
+// by-value fromString, which would have to construct a temporary object.
+template<typename T>
+struct TypeTraits<T, std::enable_if_t<is_reflectable_v<T>>> {
+    static void append(std::string& out, const T& val) {
+        Reflector<T>::dump(val, out);
+    }
+
+    static std::string toString(const T& val) {
+        std::string out;
+        append(out, val);
+        return out;
+    }
+
+    static bool tryFromString(std::string_view str, T& out) {
+        return load_fields(Reflector<T>::type, &out, str) == Status::Ok;
+    }
+};
+
+// Helper macros for member collection
+#define REFLECT_CONCAT_(x,y) x##y
+#define REFLECT_CONCAT(x,y) REFLECT_CONCAT_(x,y)
+#define REFLECT_STRINGIFY(x) #x
+
+// Upper bound on reflected members per class; also the depth of ReflectRank.
+inline constexpr size_t REFLECT_MAX_MEMBERS = 64;
+
+// Overload ranking tag: ReflectRank<N> converts to every ReflectRank<M> with
+// M < N, preferring the largest M.
+template<size_t N>
+struct ReflectRank : ReflectRank<N - 1> {};
+
+template<>
+struct ReflectRank<0> {};
+
+// Open-addressing hash map from string ids to V, with linear probing and
+// backward-shift deletion (no tombstones). Each slot keeps the full hash so
+// probes compare strings only on a hash match. Lookups take a string_view
+// and, optionally, a hash the caller computed once with hash(). Key is
+// std::string or a handle such as ObjectId, built from (key, hash).
+template<typename V, typename Key = std::string>
+class FlatHashMap {
+private:
+    struct Slot {
+        size_t hash = 0;
+        Key key;
+        V value{};
+    };
+
+public:
+    using Entry = Slot;
+
+    static size_t hash(std::string_view key) {
+        size_t h = std::hash<std::string_view>{}(key);
+        return h != 0 ? h : 1;  // 0 marks an empty slot
+    }
+
+    V* find(std::string_view key, size_t h) {
+        if (count == 0) return nullptr;
+        for (size_t i = h & mask();; i = (i + 1) & mask()) {
+            Slot& slot = slots[i];
+            if (slot.hash == 0) return nullptr;
+            if (slot.hash == h && std::string_view(slot.key) == key) return &slot.value;
+        }
+    }
+
+    const V* find(std::string_view key, size_t h) const {
+        return const_cast<FlatHashMap*>(this)->find(key, h);
+    }
+
+    // Inserts key -> value unless key is present; returns the stored entry
+    // and whether an insertion happened.
+    std::pair<Entry*, bool> tryEmplace(std::string_view key, size_t h, V value) {
+        if (count != 0) {
+            for (size_t i = h & mask(); slots[i].hash != 0; i = (i + 1) & mask()) {
+                if (slots[i].hash == h && std::string_view(slots[i].key) == key) {
+                    return { &slots[i], false };
+                }
+            }
+        }
+        if ((count + 1) * 4 > slots.size() * 3) {
+            rehash(std::max<size_t>(16, slots.size() * 2));
+        }
+        Slot& slot = slots[probeEmpty(h)];
+        slot.hash = h;
+        if constexpr (std::is_same_v<Key, std::string>) {
+            slot.key.assign(key);
+        } else {
+            slot.key = Key(key, h);
+        }
+        slot.value = std::move(value);
+        ++count;
+        return { &slot, true };
+    }
+
+    bool erase(std::string_view key, size_t h) {
+        if (count == 0) return false;
+        size_t i = h & mask();
+        for (;; i = (i + 1) & mask()) {
+            if (slots[i].hash == 0) return false;
+            if (slots[i].hash == h && std::string_view(slots[i].key) == key) break;
+        }
+        // Shift later members of the probe run back so lookups never stop
+        // early at the freed slot.
+        for (size_t j = (i + 1) & mask(); slots[j].hash != 0; j = (j + 1) & mask()) {
+            size_t home = slots[j].hash & mask();
+            if (((j - home) & mask()) >= ((j - i) & mask())) {
+                slots[i] = std::move(slots[j]);
+                i = j;
+            }
+        }
+        slots[i].hash = 0;
+        resetKey(slots[i].key);
+        slots[i].value = V{};
+        --count;
+        return true;
+    }
+
+    // Grows the table so that n entries fit without further rehashing.
+    void reserve(size_t n) {
+        size_t needed = 16;
+        while (needed * 3 < n * 4) needed *= 2;
+        if (needed > slots.size()) rehash(needed);
+    }
+
+    template<typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const Slot& slot : slots) {
+            if (slot.hash != 0) fn(std::string_view(slot.key), slot.value);
+        }
+    }
+
+    // Empties the map but keeps its capacity.
+    void clear() {
+        if (count == 0) return;
+        for (Slot& slot : slots) {
+            slot.hash = 0;
+            if constexpr (!std::is_same_v<Key, std::string>) resetKey(slot.key);
+            slot.value = V{};
+        }
+        count = 0;
+    }
+
+    size_t size() const { return count; }
+
+private:
+    std::vector<Slot> slots;  // size is zero or a power of two
+    size_t count = 0;
+
+    size_t mask() const { return slots.size() - 1; }
+
+    // Strings keep their capacity for reuse; handles drop their reference.
+    static void resetKey(Key& key) {
+        if constexpr (std::is_same_v<Key, std::string>) {
+            key.clear();
+        } else {
+            key = Key();
+        }
+    }
+
+    size_t probeEmpty(size_t h) const {
+        size_t i = h & mask();
+        while (slots[i].hash != 0) i = (i + 1) & mask();
+        return i;
+    }
+
+    void rehash(size_t capacity) {
+        std::vector<Slot> old(capacity);
+        old.swap(slots);
+        for (Slot& slot : old) {
+            if (slot.hash != 0) {
+                slots[probeEmpty(slot.hash)] = std::move(slot);
+            }
+        }
+    }
+};
+
+// Pool for object id storage. Every id lives in one reference-counted
+// block, and an object's own id and the index key it is registered under
+// share that block (see ObjectId). Blocks are carved out of large chunks
+// and recycled through free lists sized in 16-byte steps, so mass
+// construction and teardown do not allocate, or fragment the heap, per id.
+// Ids too long for the largest class fall back to operator new. The pool
+// is split by id hash the same way as ObjectIndex, so an id's block comes
+// from the pool shard that matches its index shard and registrations in
+// different shards take no common lock.
+class IdPool {
+public:
+    static constexpr size_t shard_count = 16;
+
+    // The top hash bits pick the shard; FlatHashMap probes with the low bits.
+    static size_t shardOf(size_t hash) {
+        return (hash >> (std::numeric_limits<size_t>::digits - 8)) % shard_count;
+    }
+
+    struct Block {
+        std::atomic<uint32_t> refs;
+        uint32_t length;
+        size_t hash;
+
+        const char* chars() const { return reinterpret_cast<const char*>(this + 1); }
+    };
+
+    static Block* allocate(std::string_view id, size_t hash) {
+        size_t cls = classOf(id.size());
+        void* memory;
+        if (cls < class_count) {
+            State& pool = states()[shardOf(hash)];
+            std::lock_guard lock(pool.mutex);
+            if (FreeBlock* reused = pool.free[cls]) {
+                pool.free[cls] = reused->next;
+                memory = reused;
+            } else {
+                memory = pool.carve((cls + 1) * granule);
+            }
+            ++pool.live;
+        } else {
+            memory = ::operator new(sizeof(Block) + id.size());
+        }
+        Block* block = new (memory) Block{ {1}, static_cast<uint32_t>(id.size()), hash };
+        std::memcpy(const_cast<char*>(block->chars()), id.data(), id.size());
+        return block;
+    }
+
+    static void release(Block* block) {
+        size_t cls = classOf(block->length);
+        size_t hash = block->hash;
+        block->~Block();
+        if (cls >= class_count) {
+            ::operator delete(block);
+            return;
+        }
+        State& pool = states()[shardOf(hash)];
+        std::lock_guard lock(pool.mutex);
+        FreeBlock* freed = reinterpret_cast<FreeBlock*>(block);
+        freed->next = pool.free[cls];
+        pool.free[cls] = freed;
+        --pool.live;
+    }
+
+    // Pooled blocks currently handed out.
+    static size_t liveBlocks() {
+        size_t live = 0;
+        for (State& pool : states()) {
+            std::lock_guard lock(pool.mutex);
+            live += pool.live;
+        }
+        return live;
+    }
+
+private:
+    static constexpr size_t granule = 16;
+    static constexpr size_t class_count = 16;  // blocks of up to 256 bytes
+    static constexpr size_t chunk_size = 64 * 1024;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct alignas(64) State {
+        std::mutex mutex;
+        std::array<FreeBlock*, class_count> free{};
+        std::vector<std::unique_ptr<char[]>> chunks;
+        char* cursor = nullptr;
+        char* end = nullptr;
+        size_t live = 0;
+
+        void* carve(size_t size) {
+            if (static_cast<size_t>(end - cursor) < size) {
+                chunks.push_back(std::make_unique<char[]>(chunk_size));
+                cursor = chunks.back().get();
+                end = cursor + chunk_size;
+            }
+            void* block = cursor;
+            cursor += size;
+            return block;
+        }
+    };
+
+    static_assert(sizeof(Block) % granule == 0 && alignof(Block) <= granule);
+
+    static size_t classOf(size_t length) {
+        return (sizeof(Block) + length + granule - 1) / granule - 1;
+    }
+
+    // Never destroyed: objects with static storage may release their ids
+    // after this function's statics would have been torn down.
+    static std::array<State, shard_count>& states() {
+        static auto* instance = new std::array<State, shard_count>;
+        return *instance;
+    }
+};
+
+// Shared handle to an id held by IdPool; copies share the same block.
+class ObjectId {
+public:
+    ObjectId() = default;
+    ObjectId(std::string_view id, size_t hash) : block(IdPool::allocate(id, hash)) {}
+    ObjectId(const ObjectId& other) : block(other.block) {
+        if (block) block->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    ObjectId(ObjectId&& other) noexcept : block(std::exchange(other.block, nullptr)) {}
+    ObjectId& operator=(ObjectId other) noexcept {
+        std::swap(block, other.block);
+        return *this;
+    }
+    ~ObjectId() {
+        if (block && block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            IdPool::release(block);
+        }
+    }
+
+    std::string_view view() const {
+        return block ? std::string_view(block->chars(), block->length) : std::string_view();
+    }
+    operator std::string_view() const { return view(); }
+
+    bool empty() const { return block == nullptr; }
+    size_t hash() const { return block ? block->hash : 0; }
+
+private:
+    IdPool::Block* block = nullptr;
+};
+
+// Dense integer name for a registered object: a slot index in the low 32
+// bits and the slot's generation in the high 32, written "#<value>" where
+// an id is accepted. 0 is never handed out.
+using ObjectHandle = uint64_t;
+
+// A registered object together with the member table of its dynamic type.
+// The handle tells apart objects that reuse an address and an id.
+struct ObjectRef {
+    void* object = nullptr;
+    const TypeDescriptor* type = nullptr;
+    ObjectHandle handle = 0;
+
+    explicit operator bool() const { return object != nullptr; }
+
+    // The object as T*, or null if it is not a T.
+    template<typename T>
+    T* as() const {
+        return type == &Reflector<T>::type ? static_cast<T*>(object) : nullptr;
+    }
+};
+
+// Slot table behind ObjectHandle. Slots live in fixed-size chunks that
+// never move, so lookups are lock-free: a handle resolves while its
+// generation matches the slot's. Releasing a slot bumps its generation,
+// which turns every outstanding handle to it stale before reuse. Freed
+// slots are recycled through free lists striped by object address, and
+// fresh slots come from an atomic counter, so acquiring and releasing
+// handles for different objects rarely takes the same lock.
+class HandleTable {
+public:
+    static ObjectHandle acquire(void* object, const TypeDescriptor* type) {
+        State& table = state();
+        uint32_t index = 0;
+        {
+            Stripe& stripe = stripeFor(table, object);
+            std::lock_guard lock(stripe.mutex);
+            if (!stripe.free.empty()) {
+                index = stripe.free.back();
+                stripe.free.pop_back();
+            }
+        }
+        if (index == 0) index = grow(table);
+        Slot& slot = slotAt(table, index);
+        slot.type.store(type, std::memory_order_relaxed);
+        slot.object.store(object, std::memory_order_release);
+        uint64_t generation = slot.generation.load(std::memory_order_relaxed);
+        return generation << 32 | index;
+    }
+
+    // Frees handle only while it still names object.
+    static bool release(ObjectHandle handle, const void* object) {
+        State& table = state();
+        Stripe& stripe = stripeFor(table, object);
+        std::lock_guard lock(stripe.mutex);
+        Slot* slot = lookup(table, handle);
+        if (!slot || slot->object.load(std::memory_order_relaxed) != object) return false;
+        slot->generation.fetch_add(1, std::memory_order_release);
+        slot->object.store(nullptr, std::memory_order_relaxed);
+        stripe.free.push_back(static_cast<uint32_t>(handle));
+        return true;
+    }
+
+    static std::pair<void*, const TypeDescriptor*> find(ObjectHandle handle) {
+        Slot* slot = lookup(state(), handle);
+        if (!slot) return {};
+        void* object = slot->object.load(std::memory_order_acquire);
+        const TypeDescriptor* type = slot->type.load(std::memory_order_acquire);
+        // Re-check: the slot may have been released and reused meanwhile.
+        if (slot->generation.load(std::memory_order_acquire) != handle >> 32) return {};
+        return { object, object ? type : nullptr };
+    }
+
+private:
+    static constexpr unsigned chunk_bits = 12;
+    static constexpr size_t chunk_size = size_t(1) << chunk_bits;
+    static constexpr size_t max_chunks = 4096;
+
+    struct Slot {
+        std::atomic<uint32_t> generation{0};
+        std::atomic<void*> object{nullptr};
+        std::atomic<const TypeDescriptor*> type{nullptr};
+    };
+
+    static constexpr size_t stripe_count = 16;
+
+    // Slots released by objects whose address maps here; an object always
+    // acquires and releases through the same stripe.
+    struct alignas(64) Stripe {
+        std::mutex mutex;
+        std::vector<uint32_t> free;
+    };
+
+    struct State {
+        std::atomic<uint32_t> next{1};  // slot 0 stays unused so that 0 is no handle
+        std::array<std::atomic<Slot*>, max_chunks> chunks{};
+        std::array<Stripe, stripe_count> stripes;
+    };
+
+    // Never destroyed, like IdPool: static objects release handles late.
+    static State& state() {
+        static State* instance = new State;
+        return *instance;
+    }
+
+    static Stripe& stripeFor(State& table, const void* object) {
+        uintptr_t address = reinterpret_cast<uintptr_t>(object);
+        return table.stripes[((address >> 4) ^ (address >> 12)) % stripe_count];
+    }
+
+    // Takes a slot that was never used, adding its chunk if it is the first.
+    static uint32_t grow(State& table) {
+        uint32_t index = table.next.load(std::memory_order_relaxed);
+        do {
+            if (index == chunk_size * max_chunks) {
+                throw std::length_error("Object handle table is full");
+            }
+        } while (!table.next.compare_exchange_weak(index, index + 1, std::memory_order_relaxed));
+        std::atomic<Slot*>& chunk = table.chunks[index >> chunk_bits];
+        if (!chunk.load(std::memory_order_acquire)) {
+            Slot* fresh = new Slot[chunk_size];
+            Slot* expected = nullptr;
+            if (!chunk.compare_exchange_strong(expected, fresh, std::memory_order_acq_rel)) {
+                delete[] fresh;
+            }
+        }
+        return index;
+    }
+
+    static Slot& slotAt(State& table, uint32_t index) {
+        return table.chunks[index >> chunk_bits].load(std::memory_order_acquire)
+            [index & (chunk_size - 1)];
+    }
+
+    static Slot* lookup(State& table, ObjectHandle handle) {
+        uint32_t index = static_cast<uint32_t>(handle);
+        if (index == 0 || (index >> chunk_bits) >= max_chunks) return nullptr;
+        Slot* chunk = table.chunks[index >> chunk_bits].load(std::memory_order_acquire);
+        if (!chunk) return nullptr;
+        Slot& slot = chunk[index & (chunk_size - 1)];
+        if (slot.generation.load(std::memory_order_acquire) != handle >> 32) return nullptr;
+        return &slot;
+    }
+};
+
+// Global object index: id -> (object, type descriptor) for every
+// Reflectable type, so one lookup finds an object and its member table.
+// Ids are spread over a fixed number of shards, each guarded by its own
+// reader/writer lock, so concurrent lookups only share a lock in read mode
+// and registrations contend only with lookups in the same shard (the id
+// storage and handle slots they take are split the same way or by
+// address). Shards are built on first use and never destroyed, so objects
+// with static storage may register from any translation unit, at any
+// time. A returned pointer stays valid only as long as the caller
+// otherwise guarantees the object outlives its use. Lookups also accept
+// "#<handle>" (see ObjectHandle), which skips hashing and the shard locks
+// altogether.
+class ObjectIndex {
+private:
+    static constexpr size_t shard_count = IdPool::shard_count;
+
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        FlatHashMap<ObjectRef, ObjectId> objects;
+    };
+
+    // Never destroyed, like IdPool: a static object may register after the
+    // shards were built, and so unregister after they would be torn down.
+    static std::array<Shard, shard_count>& shards() {
+        static auto* instance = new std::array<Shard, shard_count>;
+        return *instance;
+    }
+
+    // The same shard as the id's IdPool block.
+    static Shard& shardFor(size_t hash) {
+        return shards()[IdPool::shardOf(hash)];
+    }
+
+    // Bumped whenever an object leaves the index or an id is rebound, so
+    // cached pointers (see PathHandle) know when to re-check themselves.
+    static std::atomic<size_t>& generation() {
+        static std::atomic<size_t> counter{0};
+        return counter;
+    }
+
+    static ObjectRef findHandle(std::string_view id) {
+        ObjectHandle handle = 0;
+        auto [end, error] = std::from_chars(id.data() + 1, id.data() + id.size(), handle);
+        if (error != std::errc() || end != id.data() + id.size()) return ObjectRef();
+        return find(handle);
+    }
+
+public:
+    // Hash of an id as used by the index; pass it back to find() to skip
+    // rehashing ids that are looked up repeatedly.
+    static size_t hashId(std::string_view id) { return FlatHashMap<ObjectRef>::hash(id); }
+
+    // Binds id to object, which holds handle, and returns the index's
+    // interned copy of the id, for the object to keep instead of a string
+    // of its own.
+    static ObjectId registerObject(std::string_view id, void* object, const TypeDescriptor* type,
+                                   ObjectHandle handle) {
+        size_t hash = hashId(id);
+        Shard& shard = shardFor(hash);
+        std::unique_lock lock(shard.mutex);
+        auto [stored, inserted] = shard.objects.tryEmplace(id, hash, ObjectRef{ object, type, handle });
+        if (!inserted && stored->value.object != object) {
+            stored->value = ObjectRef{ object, type, handle };
+            generation().fetch_add(1, std::memory_order_release);
+        }
+        return stored->key;
+    }
+
+    // Removes id only while it still maps to object, so an object going
+    // away cannot drop a newer registration of the same id.
+    static void unregisterObject(std::string_view id, const void* object) {
+        unregisterObject(id, hashId(id), object);
+    }
+
+    static void unregisterObject(const ObjectId& id, const void* object) {
+        unregisterObject(id, id.hash(), object);
+    }
+
+    static void unregisterObject(std::string_view id, size_t hash, const void* object) {
+        Shard& shard = shardFor(hash);
+        std::unique_lock lock(shard.mutex);
+        const ObjectRef* stored = shard.objects.find(id, hash);
+        if (stored && stored->object == object) {
+            shard.objects.erase(id, hash);
+            generation().fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    // Presizes every shard for about n objects, for bulk construction.
+    static void reserve(size_t n) {
+        for (Shard& shard : shards()) {
+            std::unique_lock lock(shard.mutex);
+            shard.objects.reserve(n / shard_count + n / (shard_count * 4) + 1);
+        }
+    }
+
+    static const std::atomic<size_t>& getGeneration() { return generation(); }
+
+    static ObjectRef find(std::string_view id) {
+        if (isHandle(id)) return findHandle(id);
+        return find(id, hashId(id));
+    }
+
+    static ObjectRef find(ObjectHandle handle) {
+        auto [object, type] = HandleTable::find(handle);
+        return object ? ObjectRef{ object, type, handle } : ObjectRef();
+    }
+
+    static ObjectHandle acquireHandle(void* object, const TypeDescriptor* type) {
+        return HandleTable::acquire(object, type);
+    }
+
+    // Cached pointers to the object must re-check, as for unregisterObject.
+    static void releaseHandle(ObjectHandle handle, const void* object) {
+        if (HandleTable::release(handle, object)) {
+            generation().fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    static bool isHandle(std::string_view id) { return !id.empty() && id[0] == '#'; }
+
+    // Calls fn(id, ref) for every registered object, holding each shard's
+    // lock in read mode while it is visited; fn must not register objects.
+    template<typename Fn>
+    static void forEach(Fn&& fn) {
+        for (const Shard& shard : shards()) {
+            std::shared_lock lock(shard.mutex);
+            shard.objects.forEach(fn);
+        }
+    }
+
+    static ObjectRef find(std::string_view id, size_t hash) {
+        if (isHandle(id)) return findHandle(id);
+        const Shard& shard = shardFor(hash);
+        std::shared_lock lock(shard.mutex);
+        const ObjectRef* stored = shard.objects.find(id, hash);
+        return stored ? *stored : ObjectRef();
+    }
+};
+
+// Typed view of the global index for objects of type T. Ids share one
+// namespace across types; lookups of an id bound to another type fail.
+template<typename T>
+class ObjectRegistry {
+public:
+    static size_t hashId(std::string_view id) { return ObjectIndex::hashId(id); }
+
+    static ObjectId registerObject(std::string_view id, T* obj, ObjectHandle handle) {
+        return ObjectIndex::registerObject(id, obj, &Reflector<T>::type, handle);
+    }
+
+    static void unregisterObject(std::string_view id) {
+        if (T* obj = getObject(id)) {
+            ObjectIndex::unregisterObject(id, obj);
+        }
+    }
+
+    static void unregisterObject(std::string_view id, T* obj) {
+        ObjectIndex::unregisterObject(id, obj);
+    }
+
+    static void unregisterObject(const ObjectId& id, T* obj) {
+        ObjectIndex::unregisterObject(id, obj);
+    }
+
+    static void reserve(size_t n) { ObjectIndex::reserve(n); }
+
+    static ObjectHandle acquireHandle(T* obj) {
+        return ObjectIndex::acquireHandle(obj, &Reflector<T>::type);
+    }
+
+    static void releaseHandle(ObjectHandle handle, T* obj) {
+        ObjectIndex::releaseHandle(handle, obj);
+    }
+
+    static T* getObject(ObjectHandle handle) {
+        return ObjectIndex::find(handle).template as<T>();
+    }
+
+    static T* getObject(std::string_view id) {
+        return ObjectIndex::find(id).template as<T>();
+    }
+
+    static T* getObject(std::string_view id, size_t hash) {
+        return ObjectIndex::find(id, hash).template as<T>();
+    }
+};
+
+// Add forward declaration at the top of the namespace, before Reflectable class
+template<typename T>
+struct Reflector;
+
+template<typename T>
+struct BinaryCodec;
+
+// Base class for reflectable objects. Registration is tied to an object's
+// address, not its value: objects constructed without an id (values,
+// temporaries, members reached through their parent) stay out of the
+// registry and cost no index writes until registerAs() names them. Copies
+// and moves transfer member values only; a new object starts unregistered
+// and an assigned-to object keeps its own id and handle.
+template<typename Derived>
+class Reflectable {
+    friend class Reflector<Derived>;
+
+private:
+    ObjectId _object_id;  // shares storage with the index key
+    ObjectHandle _handle = 0;
+
+protected:
+    // An unregistered object, addressable only through a registered parent.
+    Reflectable() {
+        static_assert(std::is_base_of_v<Reflectable<Derived>, Derived>,
+            "Derived class must inherit from Reflectable<Derived>");
+    }
+
+    // Registers the object under id right away.
+    explicit Reflectable(std::string_view id) : Reflectable() {
+        _register_self(id);
+    }
+
+    Reflectable(const Reflectable&) : Reflectable() {}
+    Reflectable& operator=(const Reflectable&) { return *this; }
+
+    void _register_self(std::string_view id) {
+        if (id.empty()) {
+            throw std::invalid_argument("Object ID cannot be empty");
+        }
+        if (ObjectIndex::isHandle(id)) {
+            throw std::invalid_argument("Object ID cannot start with '#'");
+        }
+        // The handle comes first: acquiring it can throw, and an id indexed
+        // before that would outlive the object, since ~Reflectable only
+        // unregisters objects that hold a handle.
+        Derived* self = _derived();
+        if (ObjectIndex::find(_handle).object != self) {
+            _handle = ObjectRegistry<Derived>::acquireHandle(self);
+        }
+        _object_id = ObjectRegistry<Derived>::registerObject(id, self, _handle);
+    }
+
+    // The enclosing Derived's address. The constructor registers before
+    // Derived is constructed; only the adjusted pointer is kept and nothing
+    // is accessed through it until then, so the dynamic-type check that
+    // UBSan applies to downcasts does not hold yet and is skipped.
+    __attribute__((no_sanitize("vptr"))) Derived* _derived() {
+        return static_cast<Derived*>(this);
+    }
+
+public:
+    // Empty, and getHandle() 0, until the object is registered.
+    std::string_view getObjectId() const { return _object_id; }
+    bool isRegistered() const { return !_object_id.empty(); }
+
+    // Stays the same across registerAs(); "#" + handle works wherever an id does.
+    ObjectHandle getHandle() const { return _handle; }
+
+    void registerAs(std::string_view id) {
+        if (id.empty()) {
+            throw std::invalid_argument("Object ID cannot be empty");
+        }
+        if (!_object_id.empty()) {
+            ObjectRegistry<Derived>::unregisterObject(_object_id, _derived());
+            _object_id = ObjectId();
+        }
+        _register_self(id);
+    }
+
+    // Derived is already destroyed here, so the registered address comes
+    // from the handle slot (every registered object holds a handle) rather
+    // than from a downcast.
+    virtual ~Reflectable() {
+        if (!_handle) return;
+        const void* self = ObjectIndex::find(_handle).object;
+        if (!_object_id.empty()) ObjectIndex::unregisterObject(_object_id, self);
+        ObjectIndex::releaseHandle(_handle, self);
+    }
+
+    // Called by the generated set_<member>() setters.
+    void _reflect_mark_changed(size_t index) {
+        if constexpr (has_change_tracker_v<Derived>) {
+            static_cast<Derived*>(this)->_reflect_changes.mark(index);
+        }
+    }
+
+    // Terminates the member index chain emitted by REFLECT_MEMBER: a class
+    // without reflected members resolves to index 0.
+    static std::integral_constant<size_t, 0> _reflect_index(ReflectRank<0>);
+
+    static constexpr size_t _reflect_member_count() {
+        return decltype(Derived::_reflect_index(ReflectRank<REFLECT_MAX_MEMBERS>{}))::value;
+    }
+
+    template<size_t... Is>
+    static constexpr auto _get_reflection_data(std::index_sequence<Is...>) {
+        return std::make_tuple(
+            decltype(Derived::_reflect_member(std::integral_constant<size_t, Is>{})){}...);
+    }
+
+    static constexpr auto _reflect_members() {
+        return _get_reflection_data(std::make_index_sequence<_reflect_member_count()>{});
+    }
+};
+
+// Helper macros for member reflection.
+// Each member looks up the number of members declared before it through the
+// highest-ranked _reflect_index overload visible at that point, then declares
+// the next one, so indices are dense and local to the class.
+#define REFLECT_MEMBER(Type, Name, DefaultValue)                                \
+    Type Name = DefaultValue;                                                   \
+    struct REFLECT_CONCAT(member_info_, Name) {                                \
+        static constexpr const char* name = REFLECT_STRINGIFY(Name);           \
+        using type = Type;                                                     \
+        template<typename T>                                                   \
+        static constexpr auto pointer() {                                      \
+            return &T::Name;                                                  \
+        }                                                                      \
+    };                                                                         \
+    using REFLECT_CONCAT(_reflect_index_, Name) = decltype(_reflect_index(    \
+        ::reflection::ReflectRank<::reflection::REFLECT_MAX_MEMBERS>{}));      \
+    static std::integral_constant<size_t,                                      \
+        REFLECT_CONCAT(_reflect_index_, Name)::value + 1>                      \
+    _reflect_index(::reflection::ReflectRank<                                  \
+        REFLECT_CONCAT(_reflect_index_, Name)::value + 1>);                    \
+    static REFLECT_CONCAT(member_info_, Name)                                  \
+    _reflect_member(REFLECT_CONCAT(_reflect_index_, Name));                    \
+    void REFLECT_CONCAT(set_, Name)(Type value) {                              \
+        Name = std::move(value);                                               \
+        this->_reflect_mark_changed(REFLECT_CONCAT(_reflect_index_, Name)::value); \
+    }
+
+// Example classes
+struct Record : public Reflectable<Record> {
+    REFLECT_MEMBER(int, a, 0)
+    REFLECT_MEMBER(std::string, b, "")
+    REFLECT_TRACK_CHANGES()
+
+    Record() = default;
+    explicit Record(std::string id) : Reflectable<Record>(std::move(id)) {}
+};
+
+class A : public Reflectable<A> {
+public:
+    REFLECT_MEMBER(int, a, 1)
+    REFLECT_MEMBER(Record, d, Record())
+    std::string nonreflectable = "nonreflectable";
+    REFLECT_TRACK_CHANGES()
+
+    explicit A(std::string id)
+        : Reflectable<A>(std::move(id))
+    {
+        d.a = 2;
+        d.b = "hello";
+    }
+};
+
+// Registry for reflected types
+template<typename T>
+struct Reflector {
+    using MemberMap = std::map<std::string, std::unique_ptr<MemberInfoBase>>;
+    
+    template<typename MemberInfoT, typename Obj>
+    static void add_to_map(MemberMap& members, Obj& obj) {
+        members[MemberInfoT::name] = std::make_unique<MemberInfo<typename MemberInfoT::type>>(
+            &(obj.*(MemberInfoT::template pointer<Obj>()))
+        );
+    }
+
+    template<typename Tuple, size_t... Is>
+    static MemberMap reflect_impl(T& obj, const Tuple&, std::index_sequence<Is...>) {
+        MemberMap members;
+        (add_to_map<std::tuple_element_t<Is, Tuple>>(members, obj), ...);
+        return members;
+    }
+
+    static MemberMap reflect(T& obj) {
+        constexpr auto members = T::_reflect_members();
+        return reflect_impl(obj, members, 
+            std::make_index_sequence<std::tuple_size_v<decltype(members)>>{});
+    }
+
+    // Per-type member table, built once at compile time. Unlike reflect(),
+    // it does not depend on an object and costs no allocation to consult.
+    using Members = decltype(T::_reflect_members());
+    static constexpr size_t member_count = std::tuple_size_v<Members>;
+
+    template<size_t... Is>
+    static constexpr std::array<MemberDescriptor, member_count>
+    make_descriptors(std::index_sequence<Is...>) {
+        return {{ make_descriptor<T, std::tuple_element_t<Is, Members>, Is>()... }};
+    }
+
+    static constexpr std::array<MemberDescriptor, member_count> descriptors =
+        make_descriptors(std::make_index_sequence<member_count>{});
+
+    template<size_t... Is>
+    static constexpr std::array<MemberIndexEntry, member_count>
+    make_index(std::index_sequence<Is...>) {
+        return sort_member_index<member_count>({{
+            { std::tuple_element_t<Is, Members>::name, Is }... }});
+    }
+
+    static constexpr std::array<MemberIndexEntry, member_count> sorted_index =
+        make_index(std::make_index_sequence<member_count>{});
+
+    // Member index for name, or npos_member.
+    static constexpr size_t indexOf(std::string_view name) {
+        return find_member_index(sorted_index.data(), member_count, name);
+    }
+
+    // Appends "name=value" for every reflected member to out, separated by
+    // ','. Nested Reflectable members are flattened into dotted paths
+    // ("d.a=2"), so the output can be fed back through "load". Values escape
+    // ',', ' ' and '\\' (see escape_field_value).
+    static void dump(const T& obj, std::string& out) {
+        size_t start = out.size();
+        std::string prefix;
+        dumpFields(obj, out, prefix);
+        if (out.size() > start) out.pop_back();  // trailing ','
+    }
+
+    static void dumpFields(const T& obj, std::string& out, std::string& prefix) {
+        dumpFields(obj, out, prefix, std::make_index_sequence<member_count>{});
+    }
+
+    template<size_t... Is>
+    static void dumpFields(const T& obj, std::string& out, std::string& prefix,
+                           std::index_sequence<Is...>) {
+        (dumpMember<std::tuple_element_t<Is, Members>>(obj, out, prefix), ...);
+    }
+
+    template<typename MemberInfoT>
+    static void dumpMember(const T& obj, std::string& out, std::string& prefix) {
+        using Type = typename MemberInfoT::type;
+        const Type& value = obj.*(MemberInfoT::template pointer<T>());
+        if constexpr (is_reflectable_v<Type>) {
+            size_t mark = prefix.size();
+            prefix += MemberInfoT::name;
+            prefix += '.';
+            Reflector<Type>::dumpFields(value, out, prefix);
+            prefix.resize(mark);
+        } else {
+            out += prefix;
+            out += MemberInfoT::name;
+            out += '=';
+            size_t start = out.size();
+            append_value(out, value);
+            escape_field_value(out, start);
+            out += ',';
+        }
+    }
+
+    static void dumpObject(const void* object, std::string& out) {
+        dump(*static_cast<const T*>(object), out);
+    }
+
+    // Whether T or any nested member type keeps a ChangeTracker.
+    template<size_t... Is>
+    static constexpr bool anyNestedTracks(std::index_sequence<Is...>) {
+        return (nestedTracks<typename std::tuple_element_t<Is, Members>::type>() || ...);
+    }
+
+    template<typename Type>
+    static constexpr bool nestedTracks() {
+        if constexpr (is_reflectable_v<Type>) return Reflector<Type>::tracks_changes;
+        else return false;
+    }
+
+    static constexpr bool tracks_changes =
+        has_change_tracker_v<T> || anyNestedTracks(std::make_index_sequence<member_count>{});
+
+    // Appends "path=value" for every member changed since the previous call
+    // and clears the change bits, in the dump format. A member is reported
+    // when its own bit is set, or, for nested objects, when anything inside
+    // them is; a bit set while this runs is reported by the next call.
+    // Every bit taken is recorded in taken, if given.
+    static void collectChanges(T& obj, std::string& out, TakenChanges* taken = nullptr) {
+        size_t start = out.size();
+        std::string prefix;
+        collectFields(obj, out, prefix, taken);
+        if (out.size() > start) out.pop_back();  // trailing ','
+    }
+
+    static void collectFields(T& obj, std::string& out, std::string& prefix, TakenChanges* taken) {
+        uint64_t changed = takeChanges(obj, taken);
+        collectFields(obj, out, prefix, changed, taken, std::make_index_sequence<member_count>{});
+    }
+
+    template<size_t... Is>
+    static void collectFields(T& obj, std::string& out, std::string& prefix, uint64_t changed,
+                              TakenChanges* taken, std::index_sequence<Is...>) {
+        (collectMember<Is>(obj, out, prefix, changed, taken), ...);
+    }
+
+    static uint64_t takeChanges(T& obj, TakenChanges* taken) {
+        if constexpr (has_change_tracker_v<T>) {
+            uint64_t bits = obj._reflect_changes.take();
+            if (bits && taken) taken->emplace_back(&obj._reflect_changes, bits);
+            return bits;
+        } else {
+            return 0;
+        }
+    }
+
+    template<size_t I>
+    static void collectMember(T& obj, std::string& out, std::string& prefix, uint64_t changed,
+                              TakenChanges* taken) {
+        using MemberInfoT = std::tuple_element_t<I, Members>;
+        using Type = typename MemberInfoT::type;
+        bool own = changed & (uint64_t(1) << I);
+        if constexpr (is_reflectable_v<Type>) {
+            Type& value = obj.*(MemberInfoT::template pointer<T>());
+            if (!own && !Reflector<Type>::tracks_changes) return;
+            size_t mark = prefix.size();
+            prefix += MemberInfoT::name;
+            prefix += '.';
+            if (own) {
+                collectNested(value, out, prefix, taken);
+            } else {
+                Reflector<Type>::collectFields(value, out, prefix, taken);
+            }
+            prefix.resize(mark);
+        } else if (own) {
+            dumpMember<MemberInfoT>(obj, out, prefix);
+        }
+    }
+
+    // A nested object replaced as a whole: report all of it, and drop its
+    // pending bits since they are covered.
+    template<typename Type>
+    static void collectNested(Type& value, std::string& out, std::string& prefix,
+                              TakenChanges* taken) {
+        Reflector<Type>::clearChanges(value, taken);
+        Reflector<Type>::dumpFields(value, out, prefix);
+    }
+
+    static void clearChanges(T& obj, TakenChanges* taken) {
+        takeChanges(obj, taken);
+        clearNested(obj, taken, std::make_index_sequence<member_count>{});
+    }
+
+    template<size_t... Is>
+    static void clearNested(T& obj, TakenChanges* taken, std::index_sequence<Is...>) {
+        auto clear = [&obj, taken](auto info) {
+            using MemberInfoT = decltype(info);
+            using Type = typename MemberInfoT::type;
+            if constexpr (is_reflectable_v<Type>) {
+                if constexpr (Reflector<Type>::tracks_changes) {
+                    Reflector<Type>::clearChanges(obj.*(MemberInfoT::template pointer<T>()), taken);
+                }
+            }
+        };
+        (clear(std::tuple_element_t<Is, Members>{}), ...);
+    }
+
+    static ChangeTracker* changesOf(void* object) {
+        if constexpr (has_change_tracker_v<T>) {
+            return &static_cast<T*>(object)->_reflect_changes;
+        } else {
+            return nullptr;
+        }
+    }
+
+    static void deltaObject(void* object, std::string& out, TakenChanges* taken) {
+        collectChanges(*static_cast<T*>(object), out, taken);
+    }
+
+    static void encodeObject(const void* object, std::string& out) {
+        BinaryCodec<T>::encode(*static_cast<const T*>(object), out);
+    }
+
+    static bool decodeObject(std::string_view in, void* object) {
+        return BinaryCodec<T>::decode(in, *static_cast<T*>(object));
+    }
+
+    static constexpr TypeDescriptor type = {
+        descriptors.data(), sorted_index.data(), member_count, &dumpObject,
+        sizeof(T), &encodeObject, &decodeObject,
+        has_change_tracker_v<T> ? &changesOf : nullptr, &deltaObject };
+
+    static BoundMember find(T& obj, std::string_view name) {
+        size_t index = indexOf(name);
+        if (index == npos_member) return BoundMember();
+        return BoundMember(&descriptors[index], &obj, changesOf(&obj), index);
+    }
+
+    static BoundMember resolve(T& obj, std::string_view path) {
+        return resolve_path(type, &obj, path);
+    }
+
+    // Calls fn(std::integral_constant<size_t, I>, member) for the member
+    // at index, through a comparison chain over the member list that the
+    // compiler lowers to a switch; false if there is no such member.
+    template<typename Fn>
+    static bool visit(T& obj, size_t index, Fn&& fn) {
+        return visit(obj, index, fn, std::make_index_sequence<member_count>{});
+    }
+
+    // Runs a get, set, dump, load or delta on obj with every type along the
+    // path known at compile time: each segment is found in the constexpr
+    // name index and reached through visit(), and values convert through
+    // their own TypeTraits, so nothing is called through a descriptor. A
+    // load applies its fields as typed sets, stopping at the first failure.
+    // Results and side effects (change bits, watches) match
+    // ReflectionParser::execute. Other operations are UnknownOperation.
+    static Status execute(T& obj, Operation operation, std::string_view path,
+                          std::string_view value, std::string& out) {
+        switch (operation) {
+            case Operation::Get:
+                return access<Operation::Get>(obj, path, value, out, nullptr, 0);
+            case Operation::Set:
+                return access<Operation::Set>(obj, path, value, out, nullptr, 0);
+            case Operation::Dump:
+                dump(obj, out);
+                return Status::Ok;
+            case Operation::Load:
+                return load(obj, value);
+            case Operation::Delta:
+                collectChanges(obj, out);
+                return Status::Ok;
+            default:
+                return Status::UnknownOperation;
+        }
+    }
+
+private:
+    template<typename> friend struct Reflector;
+
+    // Typed counterpart of load_fields(); the sets' value echoes go to a
+    // scratch string rather than the result.
+    static Status load(T& obj, std::string_view payload) {
+        std::string echo;
+        return for_each_field(payload, [&](std::string_view path, std::string_view value) {
+            echo.clear();
+            return access<Operation::Set>(obj, path, value, echo, nullptr, 0);
+        });
+    }
+
+    template<Operation Op>
+    static Status access(T& obj, std::string_view path, std::string_view value, std::string& out,
+                         ChangeTracker* tracker, size_t changeBit) {
+        size_t dot = path.find('.');
+        size_t index = indexOf(path.substr(0, dot));
+        if constexpr (has_change_tracker_v<T>) {
+            tracker = &obj._reflect_changes;
+            changeBit = index;
+        }
+        Status status = Status::MemberNotFound;
+        visit(obj, index, [&](auto member, auto& field) {
+            using Type = std::decay_t<decltype(field)>;
+            if (dot != std::string_view::npos) {
+                if constexpr (is_reflectable_v<Type>) {
+                    status = Reflector<Type>::template access<Op>(
+                        field, path.substr(dot + 1), value, out, tracker, changeBit);
+                }
+            } else if constexpr (Op == Operation::Set) {
+                if (!assign_from_string(field, value)) {
+                    status = Status::InvalidValue;
+                    return;
+                }
+                if (tracker) tracker->mark(changeBit);
+                if (active_watch_count.load(std::memory_order_relaxed) != 0) {
+                    notify_watchers(&obj, decltype(member)::value);
+                }
+                out.append(value);
+                status = Status::Ok;
+            } else {
+                append_value(out, field);
+                status = Status::Ok;
+            }
+        });
+        return status;
+    }
+
+    template<typename Fn, size_t... Is>
+    static bool visit(T& obj, size_t index, Fn& fn, std::index_sequence<Is...>) {
+        return ((index == Is &&
+                 (fn(std::integral_constant<size_t, Is>{},
+                     obj.*(std::tuple_element_t<Is, Members>::template pointer<T>())), true)) || ...);
+    }
+};
+
+// Binary wire format.
+// Objects encode as an 8-byte schema hash followed by their reflected
+// members in declaration order:
+//   - trivially copyable members: raw bytes in host byte order; members
+//     that sit back to back in memory are copied as one block
+//   - std::string: varint length, then the bytes
+//   - nested Reflectable members: their own members, inline (no header)
+//   - anything else: varint length, then the TypeTraits text form
+// The schema hash covers member names, encodings and sizes (recursively),
+// so a receiver can reject payloads from a different layout.
+namespace wire {
+
+constexpr uint64_t fnv1a(uint64_t hash, std::string_view bytes) {
+    for (char c : bytes) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+constexpr uint64_t mix(uint64_t hash, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        hash = (hash ^ ((value >> (i * 8)) & 0xff)) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+inline void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+inline bool getVarint(std::string_view& in, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && !in.empty(); shift += 7) {
+        auto byte = static_cast<unsigned char>(in.front());
+        in.remove_prefix(1);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+// Reads a varint length and that many bytes.
+inline bool getBytes(std::string_view& in, std::string_view& bytes) {
+    uint64_t size;
+    if (!getVarint(in, size) || size > in.size()) return false;
+    bytes = in.substr(0, size);
+    in.remove_prefix(size);
+    return true;
+}
+
+enum class Encoding : uint64_t { Fixed = 1, String = 2, Nested = 3, Text = 4 };
+
+template<typename T>
+constexpr Encoding encoding_of() {
+    if constexpr (is_reflectable_v<T>) return Encoding::Nested;
+    else if constexpr (std::is_same_v<T, std::string>) return Encoding::String;
+    else if constexpr (std::is_trivially_copyable_v<T> && !std::is_pointer_v<T>) return Encoding::Fixed;
+    else return Encoding::Text;
+}
+
+// Object bytes of consecutive fixed members not yet copied.
+template<typename Byte>
+struct Run {
+    Byte* begin = nullptr;
+    Byte* end = nullptr;
+};
+
+// An empty run has null pointers, which append() and memcpy() must not see.
+inline void flush(Run<const char>& run, std::string& out) {
+    if (run.begin == run.end) return;
+    out.append(run.begin, run.end - run.begin);
+    run = {};
+}
+
+inline bool flush(Run<char>& run, std::string_view& in) {
+    size_t size = run.end - run.begin;
+    if (size == 0) return true;
+    if (in.size() < size) return false;
+    std::memcpy(run.begin, in.data(), size);
+    in.remove_prefix(size);
+    run = {};
+    return true;
+}
+
+// Encodes one member value. Fixed-size values only extend run (flushed by
+// the caller), so neighbours in memory are copied as one block.
+template<typename Type>
+void encodeValue(const Type& value, std::string& out, Run<const char>& run) {
+    constexpr Encoding encoding = encoding_of<Type>();
+
+    if constexpr (encoding == Encoding::Fixed) {
+        const char* bytes = reinterpret_cast<const char*>(&value);
+        if (bytes != run.end) {
+            flush(run, out);
+            run.begin = bytes;
+        }
+        run.end = bytes + sizeof(Type);
+        return;
+    }
+
+    flush(run, out);
+    if constexpr (encoding == Encoding::String) {
+        putVarint(out, value.size());
+        out += value;
+    } else if constexpr (encoding == Encoding::Nested) {
+        BinaryCodec<Type>::encodeFields(value, out);
+    } else if constexpr (encoding == Encoding::Text) {
+        std::string text = TypeTraits<Type>::toString(value);
+        putVarint(out, text.size());
+        out += text;
+    }
+}
+
+template<typename Type>
+bool decodeValue(std::string_view& in, Type& value, Run<char>& run) {
+    constexpr Encoding encoding = encoding_of<Type>();
+
+    if constexpr (encoding == Encoding::Fixed) {
+        char* bytes = reinterpret_cast<char*>(&value);
+        if (bytes != run.end) {
+            if (!flush(run, in)) return false;
+            run.begin = bytes;
+        }
+        run.end = bytes + sizeof(Type);
+        return true;
+    }
+
+    if (!flush(run, in)) return false;
+    if constexpr (encoding == Encoding::Nested) {
+        return BinaryCodec<Type>::decodeFields(in, value);
+    } else {
+        std::string_view bytes;
+        if (!getBytes(in, bytes)) return false;
+        if constexpr (encoding == Encoding::String) {
+            value.assign(bytes);
+            return true;
+        } else {
+            return assign_from_string(value, bytes);
+        }
+    }
+}
+
+} // namespace wire
+
+template<typename T>
+struct BinaryCodec {
+    using Members = typename Reflector<T>::Members;
+    static constexpr size_t member_count = Reflector<T>::member_count;
+
+private:
+    template<typename MemberInfoT>
+    static constexpr uint64_t memberSchema(uint64_t hash) {
+        using Type = typename MemberInfoT::type;
+        constexpr wire::Encoding encoding = wire::encoding_of<Type>();
+        hash = wire::mix(wire::fnv1a(hash, MemberInfoT::name), static_cast<uint64_t>(encoding));
+        if constexpr (encoding == wire::Encoding::Fixed) {
+            hash = wire::mix(hash, sizeof(Type));
+            hash = wire::mix(hash, std::is_floating_point_v<Type> * 2 + std::is_signed_v<Type>);
+        } else if constexpr (encoding == wire::Encoding::Nested) {
+            hash = wire::mix(hash, BinaryCodec<Type>::schema_hash);
+        }
+        return hash;
+    }
+
+    template<size_t... Is>
+    static constexpr uint64_t makeSchemaHash(std::index_sequence<Is...>) {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        ((hash = memberSchema<std::tuple_element_t<Is, Members>>(hash)), ...);
+        return hash;
+    }
+
+public:
+    static constexpr uint64_t schema_hash = makeSchemaHash(std::make_index_sequence<member_count>{});
+
+    // Appends the schema header and all members to out.
+    static void encode(const T& obj, std::string& out) {
+        out.append(reinterpret_cast<const char*>(&schema_hash), sizeof(schema_hash));
+        encodeFields(obj, out);
+    }
+
+    // Decodes a payload produced by encode() into obj, in place. Fails on a
+    // schema mismatch, truncation or trailing bytes; obj may then be
+    // partially updated.
+    static bool decode(std::string_view in, T& obj) {
+        uint64_t hash;
+        if (in.size() < sizeof(hash)) return false;
+        std::memcpy(&hash, in.data(), sizeof(hash));
+        if (hash != schema_hash) return false;
+        in.remove_prefix(sizeof(hash));
+        return decodeFields(in, obj) && in.empty();
+    }
+
+    // Members only, without the header; used for nested objects.
+    static void encodeFields(const T& obj, std::string& out) {
+        wire::Run<const char> run;
+        encodeFields(obj, out, run, std::make_index_sequence<member_count>{});
+        wire::flush(run, out);
+    }
+
+    static bool decodeFields(std::string_view& in, T& obj) {
+        wire::Run<char> run;
+        return decodeFields(in, obj, run, std::make_index_sequence<member_count>{}) &&
+               wire::flush(run, in);
+    }
+
+private:
+    template<size_t... Is>
+    static void encodeFields(const T& obj, std::string& out, wire::Run<const char>& run,
+                             std::index_sequence<Is...>) {
+        (encodeMember<std::tuple_element_t<Is, Members>>(obj, out, run), ...);
+    }
+
+    template<size_t... Is>
+    static bool decodeFields(std::string_view& in, T& obj, wire::Run<char>& run,
+                             std::index_sequence<Is...>) {
+        return (decodeMember<std::tuple_element_t<Is, Members>>(in, obj, run) && ...);
+    }
+
+    template<typename MemberInfoT>
+    static void encodeMember(const T& obj, std::string& out, wire::Run<const char>& run) {
+        wire::encodeValue(obj.*(MemberInfoT::template pointer<T>()), out, run);
+    }
+
+    template<typename MemberInfoT>
+    static bool decodeMember(std::string_view& in, T& obj, wire::Run<char>& run) {
+        return wire::decodeValue(in, obj.*(MemberInfoT::template pointer<T>()), run);
+    }
+};
+
+// Struct-of-arrays storage for many objects of one reflected type: each
+// REFLECT_MEMBER field lives in its own contiguous column, so a scan over
+// one field is a linear sweep instead of a pointer chase per object. Rows
+// are not T objects; T is only the schema. A row joins the reflection layer
+// once registered under an id: it then works with the text commands,
+// compiled paths, typed access, watches and snapshots like any object, and
+// encodes to the same BinaryCodec<T> payload. Rows start value-initialized
+// (not with the REFLECT_MEMBER defaults) unless copied from a T. Columns
+// may grow, which moves their elements but not the rows' identities.
+// Members must not themselves be Reflectable, and rows do not track changes.
+// A bool column holds ColumnBool cells rather than std::vector<bool>'s
+// packed bits, so every row has its own bool& and rows can be written from
+// different threads.
+struct ColumnBool {
+    bool value = false;
+
+    ColumnBool() = default;
+    ColumnBool(bool value) : value(value) {}
+    operator bool() const { return value; }
+};
+
+template<typename T>
+class ReflectableColumnStore {
+    using Members = typename Reflector<T>::Members;
+    static constexpr size_t member_count = Reflector<T>::member_count;
+
+    template<size_t I>
+    using MemberInfoAt = std::tuple_element_t<I, Members>;
+
+    template<typename Type>
+    using CellOf = std::conditional_t<std::is_same_v<Type, bool>, ColumnBool, Type>;
+
+    template<size_t... Is>
+    static auto makeColumns(std::index_sequence<Is...>)
+        -> std::tuple<std::vector<CellOf<typename MemberInfoAt<Is>::type>>...>;
+
+    using Columns = decltype(makeColumns(std::make_index_sequence<member_count>{}));
+
+    template<size_t... Is>
+    static constexpr bool flat(std::index_sequence<Is...>) {
+        return (!is_reflectable_v<typename MemberInfoAt<Is>::type> && ...);
+    }
+    static_assert(flat(std::make_index_sequence<member_count>{}),
+                  "ReflectableColumnStore needs members that are not Reflectable themselves");
+
+public:
+    template<size_t I>
+    using ColumnType = typename MemberInfoAt<I>::type;
+
+    // Element type of column<I>(): ColumnType<I>, or ColumnBool for bool.
+    template<size_t I>
+    using CellType = CellOf<ColumnType<I>>;
+
+    // Position of a member's column, for column<I>(); usable as a template
+    // argument: store.column<ReflectableColumnStore<T>::indexOf("a")>().
+    static constexpr size_t indexOf(std::string_view name) { return Reflector<T>::indexOf(name); }
+
+    ReflectableColumnStore() = default;
+    ReflectableColumnStore(const ReflectableColumnStore&) = delete;
+    ReflectableColumnStore& operator=(const ReflectableColumnStore&) = delete;
+
+    ~ReflectableColumnStore() {
+        for (RowProxy& proxy : proxies) {
+            if (!proxy.id.empty()) ObjectIndex::unregisterObject(proxy.id, &proxy);
+            ObjectIndex::releaseHandle(proxy.handle, &proxy);
+        }
+    }
+
+    size_t size() const { return rows; }
+
+    void reserve(size_t n) {
+        std::apply([n](auto&... column) { (column.reserve(n), ...); }, columns);
+    }
+
+    // Appends a row and returns its position.
+    size_t append() {
+        std::apply([](auto&... column) { (column.emplace_back(), ...); }, columns);
+        return rows++;
+    }
+
+    size_t append(const T& from) {
+        appendFrom(from, std::make_index_sequence<member_count>{});
+        return rows++;
+    }
+
+    template<size_t I>
+    std::vector<CellType<I>>& column() { return std::get<I>(columns); }
+
+    template<size_t I>
+    const std::vector<CellType<I>>& column() const { return std::get<I>(columns); }
+
+    // Binds a member of a row, with the same access surface as for objects.
+    BoundMember member(size_t row, std::string_view name) {
+        size_t index = indexOf(name);
+        if (index == npos_member || row >= rows) return BoundMember();
+        return BoundMember(&row_descriptors[index], &proxyFor(row));
+    }
+
+    // Registers row under id so it resolves like any object.
+    ObjectHandle registerRow(size_t row, std::string_view id) {
+        if (id.empty() || ObjectIndex::isHandle(id)) {
+            throw std::invalid_argument("Row ID cannot be empty or start with '#'");
+        }
+        if (row >= rows) throw std::out_of_range("Row out of range");
+        RowProxy& proxy = proxyFor(row);
+        if (!proxy.id.empty()) ObjectIndex::unregisterObject(proxy.id, &proxy);
+        proxy.id = ObjectIndex::registerObject(id, &proxy, &row_type, proxy.handle);
+        return proxy.handle;
+    }
+
+    // Member table of registered rows (the object pointer is a row proxy).
+    static const TypeDescriptor& type() { return row_type; }
+
+private:
+    // Stable identity of one row; kept in a deque so it never moves.
+    struct RowProxy {
+        ReflectableColumnStore* store;
+        size_t row;
+        ObjectId id;
+        ObjectHandle handle = 0;
+    };
+
+    Columns columns;
+    size_t rows = 0;
+    std::deque<RowProxy> proxies;
+    std::vector<RowProxy*> proxyOfRow;
+
+    template<size_t... Is>
+    void appendFrom(const T& from, std::index_sequence<Is...>) {
+        (std::get<Is>(columns).push_back(from.*(MemberInfoAt<Is>::template pointer<T>())), ...);
+    }
+
+    RowProxy& proxyFor(size_t row) {
+        if (proxyOfRow.size() <= row) proxyOfRow.resize(rows, nullptr);
+        if (!proxyOfRow[row]) {
+            proxies.push_back({ this, row, ObjectId(), 0 });
+            proxies.back().handle = ObjectIndex::acquireHandle(&proxies.back(), &row_type);
+            proxyOfRow[row] = &proxies.back();
+        }
+        return *proxyOfRow[row];
+    }
+
+    template<size_t I>
+    struct RowAccessor {
+        using Type = ColumnType<I>;
+
+        static Type& ref(const void* object) {
+            const RowProxy* proxy = static_cast<const RowProxy*>(object);
+            auto& cell = std::get<I>(proxy->store->columns)[proxy->row];
+            if constexpr (std::is_same_v<Type, bool>) {
+                return cell.value;
+            } else {
+                return cell;
+            }
+        }
+
+        static std::string getValue(const void* object) { return TypeTraits<Type>::toString(ref(object)); }
+        static void appendValue(const void* object, std::string& out) { append_value(out, ref(object)); }
+        static char* writeValue(const void* object, char* first, char* last) {
+            return write_value(first, last, ref(object));
+        }
+        static bool setValue(void* object, std::string_view value) {
+            return assign_from_string(ref(object), value);
+        }
+        static void* address(void* object) { return &ref(object); }
+    };
+
+    template<size_t I>
+    static constexpr MemberDescriptor makeDescriptor() {
+        using Accessor = RowAccessor<I>;
+        return { MemberInfoAt<I>::name, I, type_id<ColumnType<I>>(), &Accessor::getValue,
+                 &Accessor::appendValue, &Accessor::writeValue, &Accessor::setValue,
+                 &Accessor::address, nullptr, value_ops<ColumnType<I>>() };
+    }
+
+    template<size_t... Is>
+    static constexpr std::array<MemberDescriptor, member_count>
+    makeDescriptors(std::index_sequence<Is...>) {
+        return {{ makeDescriptor<Is>()... }};
+    }
+
+    static constexpr std::array<MemberDescriptor, member_count> row_descriptors =
+        makeDescriptors(std::make_index_sequence<member_count>{});
+
+    template<size_t... Is>
+    static void dumpRow(const void* object, std::string& out, std::index_sequence<Is...>) {
+        size_t start = out.size();
+        size_t value = 0;
+        ((out += (out.size() > start ? "," : ""), out += MemberInfoAt<Is>::name, out += '=',
+          value = out.size(), append_value(out, RowAccessor<Is>::ref(object)),
+          escape_field_value(out, value)), ...);
+    }
+
+    static void dumpObject(const void* object, std::string& out) {
+        dumpRow(object, out, std::make_index_sequence<member_count>{});
+    }
+
+    template<size_t... Is>
+    static void encodeObject(const void* object, std::string& out, std::index_sequence<Is...>) {
+        uint64_t hash = BinaryCodec<T>::schema_hash;
+        out.append(reinterpret_cast<const char*>(&hash), sizeof(hash));
+        wire::Run<const char> run;
+        (wire::encodeValue(RowAccessor<Is>::ref(object), out, run), ...);
+        wire::flush(run, out);
+    }
+
+    static void encodeObject(const void* object, std::string& out) {
+        encodeObject(object, out, std::make_index_sequence<member_count>{});
+    }
+
+    template<size_t... Is>
+    static bool decodeObject(std::string_view in, void* object, std::index_sequence<Is...>) {
+        uint64_t hash;
+        if (in.size() < sizeof(hash)) return false;
+        std::memcpy(&hash, in.data(), sizeof(hash));
+        if (hash != BinaryCodec<T>::schema_hash) return false;
+        in.remove_prefix(sizeof(hash));
+        wire::Run<char> run;
+        return (wire::decodeValue(in, RowAccessor<Is>::ref(object), run) && ...) &&
+               wire::flush(run, in) && in.empty();
+    }
+
+    static bool decodeObject(std::string_view in, void* object) {
+        return decodeObject(in, object, std::make_index_sequence<member_count>{});
+    }
+
+    // Rows keep no ChangeTracker, so there is never a delta to report.
+    static void deltaObject(void*, std::string&, TakenChanges*) {}
+
+    static constexpr TypeDescriptor row_type = {
+        row_descriptors.data(), Reflector<T>::sorted_index.data(), member_count, &dumpObject,
+        sizeof(RowProxy), &encodeObject, &decodeObject, nullptr, &deltaObject };
+};
+
+// Snapshot of every registered object's reflected state in the binary
+// wire format:
+//   "IQSNAP01", u64 record count, then per object:
+//   varint id length, id, varint payload length, BinaryCodec payload
+// An object lying inside another registered object (a nested member that
+// was registered on its own) is written as part of its container only, so
+// parallel restore never has two workers writing the same memory. Objects
+// must not be created or destroyed while a snapshot is saved or restored.
+class Snapshot {
+public:
+    struct RestoreResult {
+        bool ok = false;      // file was readable and well formed
+        size_t restored = 0;
+        size_t missing = 0;   // id not registered in this process
+        size_t failed = 0;    // payload rejected, e.g. on a schema mismatch
+    };
+
+    static bool save(const std::string& path) {
+        struct Entry {
+            std::string id;
+            ObjectRef ref;
+        };
+        std::vector<Entry> entries;
+        ObjectIndex::forEach([&entries](std::string_view id, const ObjectRef& ref) {
+            entries.push_back({ std::string(id), ref });
+        });
+
+        // Outermost objects first at each address, then drop contained ones.
+        auto begin = [](const Entry& e) { return reinterpret_cast<uintptr_t>(e.ref.object); };
+        std::sort(entries.begin(), entries.end(), [&begin](const Entry& l, const Entry& r) {
+            return begin(l) != begin(r) ? begin(l) < begin(r) : l.ref.type->size > r.ref.type->size;
+        });
+        std::string records;
+        uint64_t count = 0;
+        uintptr_t coveredEnd = 0;
+        for (const Entry& entry : entries) {
+            if (begin(entry) < coveredEnd) continue;
+            coveredEnd = begin(entry) + entry.ref.type->size;
+
+            wire::putVarint(records, entry.id.size());
+            records += entry.id;
+            std::string payload;
+            entry.ref.type->encode(entry.ref.object, payload);
+            wire::putVarint(records, payload.size());
+            records += payload;
+            ++count;
+        }
+
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) return false;
+        bool ok = std::fwrite(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                  std::fwrite(&count, sizeof(count), 1, file) == 1 &&
+                  std::fwrite(records.data(), 1, records.size(), file) == records.size();
+        return std::fclose(file) == 0 && ok;
+    }
+
+    // Maps the file and applies its records to the objects registered
+    // under the same ids, spread over up to `threads` workers.
+    static RestoreResult restore(const std::string& path,
+                                 unsigned threads = std::thread::hardware_concurrency()) {
+        RestoreResult result;
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return result;
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < header_size) {
+            ::close(fd);
+            return result;
+        }
+        size_t size = info.st_size;
+        void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) return result;
+
+        std::string_view in(static_cast<const char*>(mapping), size);
+        std::vector<std::pair<std::string_view, std::string_view>> records;
+        if (parse(in, records)) {
+            result.ok = true;
+            apply(records, threads, result);
+        }
+        ::munmap(mapping, size);
+        return result;
+    }
+
+private:
+    static constexpr char magic[8] = { 'I', 'Q', 'S', 'N', 'A', 'P', '0', '1' };
+    static constexpr size_t header_size = sizeof(magic) + sizeof(uint64_t);
+
+    static bool parse(std::string_view in,
+                      std::vector<std::pair<std::string_view, std::string_view>>& records) {
+        if (in.substr(0, sizeof(magic)) != std::string_view(magic, sizeof(magic))) return false;
+        uint64_t count;
+        std::memcpy(&count, in.data() + sizeof(magic), sizeof(count));
+        in.remove_prefix(header_size);
+
+        records.reserve(std::min<uint64_t>(count, in.size()));
+        for (uint64_t i = 0; i < count; ++i) {
+            std::string_view id, payload;
+            if (!wire::getBytes(in, id) || !wire::getBytes(in, payload)) return false;
+            records.emplace_back(id, payload);
+        }
+        return in.empty();
+    }
+
+    static void apply(const std::vector<std::pair<std::string_view, std::string_view>>& records,
+                      unsigned threads, RestoreResult& result) {
+        std::atomic<size_t> restored{0}, missing{0}, failed{0};
+        auto work = [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                ObjectRef ref = ObjectIndex::find(records[i].first);
+                if (!ref) {
+                    missing.fetch_add(1, std::memory_order_relaxed);
+                } else if (ref.type->decode(records[i].second, ref.object)) {
+                    restored.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    failed.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        };
+
+        size_t workers = std::max<size_t>(1, std::min<size_t>(threads, records.size()));
+        size_t chunk = (records.size() + workers - 1) / workers;
+        std::vector<std::thread> pool;
+        for (size_t w = 1; w < workers; ++w) {
+            pool.emplace_back(work, std::min(w * chunk, records.size()),
+                              std::min((w + 1) * chunk, records.size()));
+        }
+        work(0, std::min(chunk, records.size()));
+        for (auto& thread : pool) thread.join();
+
+        result.restored = restored;
+        result.missing = missing;
+        result.failed = failed;
+    }
+};
+
+// A member path resolved once and reusable without parsing or lookups.
+// The handle remembers the root object's id and ObjectHandle; when the
+// object index reports a removal it re-checks that the id still maps to
+// the same handle and goes invalid otherwise. A handle's generation is
+// bumped when its object goes away, so another object created at the same
+// address under the same id, of whatever type, does not revive it.
+class PathHandle {
+    std::string objectId;
+    ObjectHandle root = 0;
+    BoundMember member;
+    mutable size_t seenGeneration = 0;
+    mutable bool valid = false;
+
+    bool revalidate() const {
+        size_t current = ObjectIndex::getGeneration().load(std::memory_order_acquire);
+        if (valid && current != seenGeneration) {
+            valid = ObjectIndex::find(objectId).handle == root;
+            seenGeneration = current;
+        }
+        return valid;
+    }
+
+public:
+    PathHandle() = default;
+
+    static PathHandle bind(std::string_view objectId, ObjectRef root, BoundMember member) {
+        PathHandle handle;
+        if (!root.handle || !member) return handle;
+        handle.objectId = std::string(objectId);
+        handle.root = root.handle;
+        handle.member = member;
+        handle.seenGeneration = ObjectIndex::getGeneration().load(std::memory_order_acquire);
+        handle.valid = true;
+        return handle;
+    }
+
+    explicit operator bool() const { return revalidate(); }
+
+    std::string get() const {
+        return revalidate() ? member.getValue() : "";
+    }
+
+    // Formats into [first, last); null if invalid or the value does not fit.
+    char* get(char* first, char* last) const {
+        return revalidate() ? member.writeValue(first, last) : nullptr;
+    }
+
+    bool set(std::string_view value) const {
+        return revalidate() && member.setValue(value);
+    }
+
+    template<typename T>
+    std::optional<T> get() const {
+        const T* value = revalidate() ? member.as<T>() : nullptr;
+        return value ? std::optional<T>(*value) : std::nullopt;
+    }
+
+    // String-like arguments keep going through set(string_view) as text.
+    template<typename T, typename = std::enable_if_t<
+        !std::is_convertible_v<const T&, std::string_view>>>
+    bool set(T&& value) const {
+        return revalidate() && member.set(std::forward<T>(value));
+    }
+};
+
+// Watches on reflected members. A watch names a member path and belongs to
+// a subscriber; sets through the reflection layer only queue the watch,
+// and dispatch() delivers everything queued since the last call with one
+// callback per subscriber. Repeated sets of one member between dispatches
+// coalesce into one event carrying the value current at dispatch time.
+// Watches are keyed by the member's owning object and member index, so the
+// set path does one lookup (and none at all while no watch exists).
+struct WatchEvent {
+    uint64_t watchId;
+    std::string path;
+    std::string value;
+};
+
+class WatchTable {
+public:
+    using SubscriberId = uint64_t;
+    using WatchId = uint64_t;
+    using Callback = std::function<void(const WatchEvent* events, size_t count)>;
+
+    static SubscriberId subscribe(Callback callback) {
+        State& state = instance();
+        std::lock_guard lock(state.mutex);
+        SubscriberId id = ++state.lastId;
+        state.subscribers.emplace(id, std::move(callback));
+        return id;
+    }
+
+    // Drops the subscriber and all of its watches.
+    static void unsubscribe(SubscriberId subscriber) {
+        State& state = instance();
+        std::lock_guard lock(state.mutex);
+        state.subscribers.erase(subscriber);
+        for (auto it = state.watches.begin(); it != state.watches.end();) {
+            auto next = std::next(it);
+            if (it->second.subscriber == subscriber) removeLocked(state, it->first);
+            it = next;
+        }
+    }
+
+    // Watches the member that `handle` refers to; `member` must be the same
+    // resolved member. Returns 0 if the subscriber or handle is invalid.
+    static WatchId add(SubscriberId subscriber, std::string_view path,
+                       PathHandle handle, const BoundMember& member) {
+        if (!handle || !member) return 0;
+        State& state = instance();
+        std::lock_guard lock(state.mutex);
+        if (!state.subscribers.count(subscriber)) return 0;
+        WatchId id = ++state.lastId;
+        Key key{ member.owner(), member.index() };
+        state.watches.emplace(id, Watch{ subscriber, std::string(path), std::move(handle), key });
+        {
+            Shard& shard = shardFor(key.object);
+            std::lock_guard shardLock(shard.mutex);
+            shard.byMember[key].ids.push_back(id);
+        }
+        active_watch_count.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+
+    static bool remove(WatchId id) {
+        State& state = instance();
+        std::lock_guard lock(state.mutex);
+        return removeLocked(state, id);
+    }
+
+    // Called from the set path for a member with watchers somewhere. Only
+    // the object's shard is locked, so sets of unrelated objects do not
+    // contend with each other or with subscription changes elsewhere.
+    static void notify(const void* object, size_t index) {
+        Shard& shard = shardFor(object);
+        std::lock_guard lock(shard.mutex);
+        auto it = shard.byMember.find(Key{ object, index });
+        if (it == shard.byMember.end() || it->second.pending) return;
+        it->second.pending = true;
+        shard.pending.push_back(it->first);
+    }
+
+    // Delivers queued events, in the order the watches were added, with
+    // callbacks running on the calling thread without the table locked.
+    // Watches whose object went away are dropped. Returns the number of
+    // events delivered.
+    static size_t dispatch() {
+        std::vector<WatchId> fired;
+        for (Shard& shard : shards()) {
+            std::lock_guard lock(shard.mutex);
+            for (const Key& key : shard.pending) {
+                auto it = shard.byMember.find(key);
+                if (it == shard.byMember.end()) continue;
+                it->second.pending = false;
+                fired.insert(fired.end(), it->second.ids.begin(), it->second.ids.end());
+            }
+            shard.pending.clear();
+        }
+        if (fired.empty()) return 0;
+        std::sort(fired.begin(), fired.end());
+
+        State& state = instance();
+        std::vector<std::pair<Callback, std::vector<WatchEvent>>> batches;
+        {
+            std::lock_guard lock(state.mutex);
+            std::unordered_map<SubscriberId, size_t> batchOf;
+            for (WatchId id : fired) {
+                auto it = state.watches.find(id);
+                if (it == state.watches.end()) continue;
+                Watch& watch = it->second;
+                if (!watch.handle) {
+                    removeLocked(state, id);
+                    continue;
+                }
+                auto [slot, inserted] = batchOf.try_emplace(watch.subscriber, batches.size());
+                if (inserted) batches.emplace_back(state.subscribers.at(watch.subscriber), std::vector<WatchEvent>());
+                batches[slot->second].second.push_back({ id, watch.path, watch.handle.get() });
+            }
+        }
+        size_t delivered = 0;
+        for (auto& [callback, events] : batches) {
+            if (callback) callback(events.data(), events.size());
+            delivered += events.size();
+        }
+        return delivered;
+    }
+
+private:
+    struct Key {
+        const void* object;
+        size_t index;
+        bool operator==(const Key& other) const {
+            return object == other.object && index == other.index;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return std::hash<const void*>{}(key.object) * 31 + key.index;
+        }
+    };
+
+    struct Watch {
+        SubscriberId subscriber;
+        std::string path;
+        PathHandle handle;
+        Key key;
+    };
+
+    // Subscribers and watch definitions; taken before any shard lock.
+    struct State {
+        std::mutex mutex;
+        uint64_t lastId = 0;
+        std::unordered_map<SubscriberId, Callback> subscribers;
+        std::unordered_map<WatchId, Watch> watches;
+    };
+
+    struct Watched {
+        std::vector<WatchId> ids;
+        bool pending = false;  // queued in its shard since the last dispatch
+    };
+
+    // Per-member watch lists and pending notifications, split by object.
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<Key, Watched, KeyHash> byMember;
+        std::vector<Key> pending;
+    };
+
+    static constexpr size_t shard_count = 64;
+
+    // Never destroyed, like ObjectIndex's shards: sets and destructors of
+    // static objects may reach the table late.
+    static State& instance() {
+        static State* state = new State;
+        return *state;
+    }
+
+    static std::array<Shard, shard_count>& shards() {
+        static auto* table = new std::array<Shard, shard_count>;
+        return *table;
+    }
+
+    static Shard& shardFor(const void* object) {
+        uintptr_t address = reinterpret_cast<uintptr_t>(object);
+        return shards()[((address >> 4) ^ (address >> 12)) % shard_count];
+    }
+
+    static bool removeLocked(State& state, WatchId id) {
+        auto it = state.watches.find(id);
+        if (it == state.watches.end()) return false;
+        const Key& key = it->second.key;
+        {
+            Shard& shard = shardFor(key.object);
+            std::lock_guard lock(shard.mutex);
+            auto watched = shard.byMember.find(key);
+            auto& ids = watched->second.ids;
+            ids.erase(std::find(ids.begin(), ids.end(), id));
+            if (ids.empty()) shard.byMember.erase(watched);
+        }
+        state.watches.erase(it);
+        active_watch_count.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+};
+
+inline void notify_watchers(const void* object, size_t index) {
+    WatchTable::notify(object, index);
+}
+
+// Opt-in instrumentation of command execution. Each thread records into
+// its own buffer: a log2 histogram of cycle counts per stage plus lookup
+// hit/miss counters, written with plain relaxed stores so recording never
+// contends. report() sums all buffers on demand. Buffers of exited threads
+// are kept, with their counts, and handed to the next new thread. With
+// REFLECTION_INSTRUMENT=0 every hook is an empty inline function.
+namespace instrument {
+
+inline constexpr bool enabled = REFLECTION_INSTRUMENT != 0;
+
+enum class Stage { Parse, Lookup, Resolve, Convert, Command, count };
+enum class Counter { LookupHit, LookupMiss, BatchCacheHit, MemberHit, MemberMiss, count };
+
+inline constexpr const char* stage_names[] = { "parse", "lookup", "resolve", "convert", "command" };
+inline constexpr const char* counter_names[] = {
+    "lookup_hit", "lookup_miss", "batch_cache_hit", "member_hit", "member_miss"
+};
+
+inline constexpr size_t stage_count = static_cast<size_t>(Stage::count);
+inline constexpr size_t counter_count = static_cast<size_t>(Counter::count);
+inline constexpr size_t bucket_count = 40;  // bucket b holds counts below 2^b
+
+// Cycle counter where available, otherwise nanoseconds.
+inline uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+inline const char* unit() {
+#if defined(__x86_64__) || defined(__i386__)
+    return "cycles";
+#else
+    return "ns";
+#endif
+}
+
+struct ThreadBuffer {
+    std::array<std::array<std::atomic<uint64_t>, bucket_count>, stage_count> buckets{};
+    std::array<std::atomic<uint64_t>, stage_count> totals{};
+    std::array<std::atomic<uint64_t>, counter_count> counters{};
+    bool inUse = false;  // guarded by Buffers::mutex
+
+    // Only the owning thread writes, so a load and a store suffice.
+    static void bump(std::atomic<uint64_t>& cell, uint64_t amount) {
+        cell.store(cell.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+};
+
+struct Buffers {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> all;
+};
+
+// Never destroyed: threads may record while statics are torn down.
+inline Buffers& buffers() {
+    static Buffers* instance = new Buffers;
+    return *instance;
+}
+
+// Claims a buffer for the calling thread and returns it on thread exit.
+class BufferLease {
+public:
+    BufferLease() {
+        Buffers& pool = buffers();
+        std::lock_guard lock(pool.mutex);
+        for (auto& candidate : pool.all) {
+            if (!candidate->inUse) {
+                buffer = candidate.get();
+                break;
+            }
+        }
+        if (!buffer) {
+            pool.all.push_back(std::make_unique<ThreadBuffer>());
+            buffer = pool.all.back().get();
+        }
+        buffer->inUse = true;
+    }
+
+    ~BufferLease() {
+        std::lock_guard lock(buffers().mutex);
+        buffer->inUse = false;
+    }
+
+    ThreadBuffer& get() { return *buffer; }
+
+private:
+    ThreadBuffer* buffer = nullptr;
+};
+
+inline ThreadBuffer& local() {
+    thread_local BufferLease lease;
+    return lease.get();
+}
+
+inline void record(Stage stage, uint64_t elapsed) {
+    if constexpr (enabled) {
+        ThreadBuffer& buffer = local();
+        size_t index = static_cast<size_t>(stage);
+        size_t bucket = std::min<size_t>(64 - __builtin_clzll(elapsed | 1), bucket_count - 1);
+        ThreadBuffer::bump(buffer.buckets[index][bucket], 1);
+        ThreadBuffer::bump(buffer.totals[index], elapsed);
+    }
+}
+
+inline void count(Counter counter) {
+    if constexpr (enabled) {
+        ThreadBuffer::bump(local().counters[static_cast<size_t>(counter)], 1);
+    }
+}
+
+// Times the enclosing scope as one sample of stage.
+class ScopedStage {
+public:
+    explicit ScopedStage(Stage stage) {
+        if constexpr (enabled) {
+            this->stage = stage;
+            start = now();
+        }
+    }
+
+    ~ScopedStage() {
+        if constexpr (enabled) record(stage, now() - start);
+    }
+
+    ScopedStage(const ScopedStage&) = delete;
+    ScopedStage& operator=(const ScopedStage&) = delete;
+
+private:
+    Stage stage = Stage::Command;
+    uint64_t start = 0;
+};
+
+// Appends one line per stage ("<stage> n=.. mean=.. p50<.. p99<..") and a
+// line of counters; percentiles are histogram bucket bounds.
+inline void report(std::string& out) {
+    if constexpr (!enabled) {
+        out += "instrumentation disabled";
+        return;
+    }
+    std::array<std::array<uint64_t, bucket_count>, stage_count> buckets{};
+    std::array<uint64_t, stage_count> totals{};
+    std::array<uint64_t, counter_count> counters{};
+    {
+        Buffers& pool = buffers();
+        std::lock_guard lock(pool.mutex);
+        for (const auto& buffer : pool.all) {
+            for (size_t s = 0; s < stage_count; ++s) {
+                for (size_t b = 0; b < bucket_count; ++b) {
+                    buckets[s][b] += buffer->buckets[s][b].load(std::memory_order_relaxed);
+                }
+                totals[s] += buffer->totals[s].load(std::memory_order_relaxed);
+            }
+            for (size_t c = 0; c < counter_count; ++c) {
+                counters[c] += buffer->counters[c].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    auto percentile = [](const std::array<uint64_t, bucket_count>& histogram, uint64_t n,
+                         uint64_t permille) {
+        uint64_t rank = (n * permille + 999) / 1000, seen = 0;
+        for (size_t b = 0; b < bucket_count; ++b) {
+            seen += histogram[b];
+            if (seen >= rank) return uint64_t(1) << b;
+        }
+        return uint64_t(1) << (bucket_count - 1);
+    };
+
+    out += "unit=";
+    out += unit();
+    for (size_t s = 0; s < stage_count; ++s) {
+        uint64_t n = 0;
+        for (uint64_t c : buckets[s]) n += c;
+        out += '\n';
+        out += stage_names[s];
+        out += " n=";
+        append_value(out, n);
+        if (n == 0) continue;
+        out += " mean=";
+        append_value(out, totals[s] / n);
+        out += " p50<";
+        append_value(out, percentile(buckets[s], n, 500));
+        out += " p99<";
+        append_value(out, percentile(buckets[s], n, 990));
+    }
+    out += '\n';
+    for (size_t c = 0; c < counter_count; ++c) {
+        if (c != 0) out += ' ';
+        out += counter_names[c];
+        out += '=';
+        append_value(out, counters[c]);
+    }
+}
+
+// Zeroes every buffer. Samples racing with reset may survive it.
+inline void reset() {
+    if constexpr (enabled) {
+        Buffers& pool = buffers();
+        std::lock_guard lock(pool.mutex);
+        for (const auto& buffer : pool.all) {
+            for (auto& stage : buffer->buckets) {
+                for (auto& cell : stage) cell.store(0, std::memory_order_relaxed);
+            }
+            for (auto& cell : buffer->totals) cell.store(0, std::memory_order_relaxed);
+            for (auto& cell : buffer->counters) cell.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+} // namespace instrument
+
+class CommandPool;
+
+// Results of ReflectionParser::executeBatch. All result text shares one
+// buffer; reusing a BatchResult across batches reuses its storage.
+class BatchResult {
+public:
+    struct Entry {
+        Status status;
+        size_t offset;
+        size_t length;
+    };
+
+    size_t size() const { return entries.size(); }
+    Status status(size_t i) const { return entries[i].status; }
+    std::string_view value(size_t i) const {
+        return std::string_view(buffer).substr(entries[i].offset, entries[i].length);
+    }
+
+    void reserve(size_t commands, size_t bytes) {
+        entries.reserve(commands);
+        buffer.reserve(bytes);
+    }
+
+    void clear() {
+        entries.clear();
+        buffer.clear();
+        objects.clear();
+    }
+
+private:
+    friend class ReflectionParser;
+    friend class CommandPool;
+
+    std::vector<Entry> entries;
+    std::string buffer;
+    // Objects resolved so far in the current batch.
+    FlatHashMap<ObjectRef> objects;
+};
+
+// Sequence locks for Transaction, striped by the address of the object
+// that directly owns a member (so aliases of one object share a stripe).
+// A stripe's sequence is even while stable and odd while it is held: a
+// commit holds it while moving values in, then advances it by two, so a
+// reader that sees the same even value before and after copying knows no
+// commit overlapped. Holders take stripes in ascending order.
+class SeqLocks {
+public:
+    static constexpr size_t stripe_count = 1024;
+
+    static size_t stripeOf(const void* owner) {
+        uintptr_t address = reinterpret_cast<uintptr_t>(owner);
+        return ((address >> 4) ^ (address >> 14)) % stripe_count;
+    }
+
+    static std::atomic<uint64_t>& sequence(size_t stripe) { return stripes()[stripe].value; }
+
+    // Spins until the stripe is free, then holds it; returns the even
+    // sequence it had. Holders only move values, so waits are short.
+    static uint64_t lock(size_t stripe) {
+        std::atomic<uint64_t>& seq = sequence(stripe);
+        for (unsigned spins = 0;; ++spins) {
+            uint64_t seen = seq.load(std::memory_order_relaxed);
+            if ((seen & 1) == 0 &&
+                seq.compare_exchange_weak(seen, seen + 1, std::memory_order_acquire,
+                                          std::memory_order_relaxed)) {
+                return seen;
+            }
+            pause(spins);
+        }
+    }
+
+    // Releases a held stripe at next: the locked value plus two after a
+    // write, or the locked value itself if nothing was written.
+    static void unlock(size_t stripe, uint64_t next) {
+        sequence(stripe).store(next, std::memory_order_release);
+    }
+
+    static void pause(unsigned spins) {
+        if (spins < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+            _mm_pause();
+#endif
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    struct alignas(64) Stripe {
+        std::atomic<uint64_t> value{0};
+    };
+
+    // Never destroyed: transactions may run from static destructors.
+    static std::array<Stripe, stripe_count>& stripes() {
+        static auto* table = new std::array<Stripe, stripe_count>;
+        return *table;
+    }
+};
+
+// Generic reflection parser
+class ReflectionParser {
+    friend class Transaction;
+private:
+    friend class CommandPool;
+
+    static inline std::atomic<WatchTable::SubscriberId> watchSubscriber{0};
+
+    // Commands are "<op> <path>[=<value>]" (get, set, watch), "dump <id>",
+    // "delta <id>", "load <id> <payload>" or "unwatch <watch id>"; anything
+    // past the third token is ignored. An <id> may be "#<handle>". "stats"
+    // (or "stats reset") reports the instrument counters. The id of a get
+    // or set may be a glob pattern (see query()): get then answers one
+    // "<id>.<path>=<value>" line per match, and set answers the number of
+    // objects it updated.
+    static constexpr size_t max_tokens = 3;
+
+    struct Tokens {
+        std::array<std::string_view, max_tokens> items;
+        size_t size = 0;
+    };
+
+    static Tokens tokenize(std::string_view cmd) {
+        Tokens tokens;
+        size_t pos = 0;
+        while (pos < cmd.size() && tokens.size < max_tokens) {
+            size_t end = cmd.find(' ', pos);
+            if (end == std::string_view::npos) end = cmd.size();
+            if (end != pos) {
+                tokens.items[tokens.size++] = cmd.substr(pos, end - pos);
+            }
+            pos = end + 1;
+        }
+        return tokens;
+    }
+
+    // Splits "<object>.<member path>" at the first dot.
+    static bool splitPath(std::string_view path, std::string_view& objectId,
+                          std::string_view& memberPath) {
+        size_t firstDot = path.find('.');
+        if (firstDot == std::string_view::npos) return false;
+        objectId = path.substr(0, firstDot);
+        memberPath = path.substr(firstDot + 1);
+        return true;
+    }
+
+    static BoundMember resolve(std::string_view path) {
+        std::string_view objectId, memberPath;
+        if (!splitPath(path, objectId, memberPath)) return BoundMember();
+
+        ObjectRef ref = ObjectIndex::find(objectId);
+        return ref ? resolve_path(*ref.type, ref.object, memberPath) : BoundMember();
+    }
+
+public:
+    // Resolves "<object>.<member path>" once for repeated get/set. Returns an
+    // invalid handle if the object or member does not exist.
+    static PathHandle compile(std::string_view path) {
+        std::string_view objectId, memberPath;
+        if (!splitPath(path, objectId, memberPath)) return PathHandle();
+
+        ObjectRef ref = ObjectIndex::find(objectId);
+        if (!ref) return PathHandle();
+        return PathHandle::bind(objectId, ref, resolve_path(*ref.type, ref.object, memberPath));
+    }
+
+    // Calls fn(id, member) for every registered object whose id matches the
+    // glob before the first '.' of pattern and whose type has the member
+    // path after it; returns the number of calls. The path is resolved once
+    // per type. Ids are hashed, so there is no ordered range to scan: every
+    // id is visited, in index order, and rejected on its literal prefix
+    // before the glob is tried. fn runs under the index's read locks and
+    // must not create or destroy Reflectable objects.
+    template<typename Fn>
+    static size_t query(std::string_view pattern, Fn&& fn) {
+        std::string_view glob, memberPath;
+        if (!splitPath(pattern, glob, memberPath)) return 0;
+        std::string_view prefix = glob.substr(0, glob.find_first_of("*?"));
+
+        // Resolved path per type seen; invalid where the type lacks it.
+        std::vector<std::pair<const TypeDescriptor*, MemberPath>> resolved;
+        size_t matches = 0;
+        ObjectIndex::forEach([&](std::string_view id, const ObjectRef& ref) {
+            if (id.substr(0, prefix.size()) != prefix || !glob_match(glob, id)) return;
+            auto cached = std::find_if(resolved.begin(), resolved.end(),
+                [&ref](const auto& entry) { return entry.first == ref.type; });
+            if (cached == resolved.end()) {
+                resolved.emplace_back(ref.type, MemberPath::resolve(*ref.type, memberPath));
+                cached = resolved.end() - 1;
+            }
+            if (!cached->second) return;
+            fn(id, cached->second.bind(ref.object));
+            ++matches;
+        });
+        return matches;
+    }
+
+    // Subscriber that "watch" commands register their watches for.
+    static void setWatchSubscriber(WatchTable::SubscriberId subscriber) {
+        watchSubscriber.store(subscriber, std::memory_order_relaxed);
+    }
+
+    // Watches "<object>.<member path>" for subscriber; 0 if it does not resolve.
+    static WatchTable::WatchId watch(WatchTable::SubscriberId subscriber, std::string_view path) {
+        std::string_view objectId, memberPath;
+        if (!splitPath(path, objectId, memberPath)) return 0;
+        ObjectRef ref = ObjectIndex::find(objectId);
+        if (!ref) return 0;
+        BoundMember member = resolve_path(*ref.type, ref.object, memberPath);
+        return WatchTable::add(subscriber, path, PathHandle::bind(objectId, ref, member), member);
+    }
+
+    // Typed access for in-process callers: values are copied or moved
+    // directly, without going through TypeTraits string conversion. Fails
+    // if the path does not resolve or the member is not exactly of type T.
+    template<typename T>
+    static std::optional<T> get(std::string_view path) {
+        const T* value = resolve(path).template as<T>();
+        return value ? std::optional<T>(*value) : std::nullopt;
+    }
+
+    template<typename T>
+    static bool set(std::string_view path, T&& value) {
+        return resolve(path).set(std::forward<T>(value));
+    }
+
+    // Reads several members, of one or more objects, as one state with
+    // respect to Transaction commits: never half of a commit. Each path's
+    // member must be exactly of the matching output's type (InvalidValue
+    // otherwise; MemberNotFound if a path does not resolve). When every type
+    // is trivially copyable the read is optimistic and retries if a commit
+    // overlapped it; otherwise it holds the owners' seqlocks for the copy,
+    // which waits out a commit's publish step but never its conversions.
+    //   int a; std::string b;
+    //   ReflectionParser::read({ "cfg.a", "cfg.b" }, a, b);
+    template<typename... Ts>
+    static Status read(const std::string_view (&paths)[sizeof...(Ts)], Ts&... out) {
+        return read(paths, std::index_sequence_for<Ts...>{}, out...);
+    }
+
+private:
+    struct Command {
+        Operation operation;
+        std::string_view objectId;
+        std::string_view memberPath;
+        std::string_view value;
+    };
+
+    static Status parseCommand(std::string_view cmd, Command& command) {
+        instrument::ScopedStage timer(instrument::Stage::Parse);
+        auto tokens = tokenize(cmd);
+        std::optional<Operation> operation =
+            operation_from_token(tokens.size > 0 ? tokens.items[0] : std::string_view());
+        if (operation == Operation::Stats) {
+            if (tokens.size > 1 && tokens.items[1] != "reset") return Status::InvalidCommand;
+            command.operation = Operation::Stats;
+            command.objectId = command.memberPath = std::string_view();
+            command.value = tokens.size > 1 ? tokens.items[1] : std::string_view();
+            return Status::Ok;
+        }
+        if (tokens.size < 2) return Status::InvalidCommand;
+        if (!operation) return Status::UnknownOperation;
+        command.operation = *operation;
+
+        std::string_view pathSpec = tokens.items[1];
+        command.value = std::string_view();
+
+        if (command.operation == Operation::Unwatch) {
+            command.objectId = command.memberPath = std::string_view();
+            command.value = pathSpec;
+            return Status::Ok;
+        }
+
+        // Whole-object operations take a bare id.
+        if (command.operation == Operation::Dump || command.operation == Operation::Load ||
+            command.operation == Operation::Delta) {
+            if (command.operation == Operation::Load) {
+                // The rest of the line, as escaped values may contain spaces;
+                // trailing spaces that are not escaped are dropped.
+                if (tokens.size < 3) return Status::InvalidCommand;
+                std::string_view rest = cmd.substr(tokens.items[2].data() - cmd.data());
+                size_t end = rest.size();
+                while (end > 0 && rest[end - 1] == ' ') {
+                    size_t slashes = 0;
+                    while (slashes + 1 < end && rest[end - 2 - slashes] == '\\') ++slashes;
+                    if (slashes % 2) break;
+                    --end;
+                }
+                command.value = rest.substr(0, end);
+            }
+            command.objectId = pathSpec;
+            command.memberPath = std::string_view();
+            return Status::Ok;
+        }
+
+        if (command.operation == Operation::Set) {
+            size_t eqPos = pathSpec.find('=');
+            if (eqPos == std::string_view::npos) return Status::InvalidCommand;
+            command.value = pathSpec.substr(eqPos + 1);
+            pathSpec = pathSpec.substr(0, eqPos);
+        }
+
+        if (!splitPath(pathSpec, command.objectId, command.memberPath)) {
+            return Status::InvalidCommand;
+        }
+        return Status::Ok;
+    }
+
+    static bool isQuery(const Command& command) {
+        return (command.operation == Operation::Get || command.operation == Operation::Set) &&
+               is_pattern(command.objectId);
+    }
+
+    // Runs a get or set whose object id is a glob pattern against every match;
+    // ObjectNotFound if no object with that member matches. A set stores the
+    // value wherever it converts and fails with InvalidValue if any match
+    // rejected it.
+    static std::string_view patternOf(const Command& command) {
+        return std::string_view(command.objectId.data(),
+                                command.memberPath.data() + command.memberPath.size() -
+                                command.objectId.data());
+    }
+
+    static Status applyQuery(const Command& command, std::string& out) {
+        size_t start = out.size(), updated = 0;
+        bool rejected = false;
+        size_t matches = query(patternOf(command), [&](std::string_view id, const BoundMember& member) {
+            if (command.operation == Operation::Set) {
+                if (member.setValue(command.value)) ++updated; else rejected = true;
+                return;
+            }
+            if (out.size() != start) out += '\n';
+            out += id;
+            out += '.';
+            out += command.memberPath;
+            out += '=';
+            member.appendValue(out);
+        });
+        if (matches == 0) return Status::ObjectNotFound;
+        if (command.operation == Operation::Set) {
+            append_value(out, updated);
+            if (rejected) return Status::InvalidValue;
+        }
+        return Status::Ok;
+    }
+
+    static BoundMember resolveMember(const Command& command, ObjectRef ref) {
+        instrument::ScopedStage timer(instrument::Stage::Resolve);
+        BoundMember member = resolve_path(*ref.type, ref.object, command.memberPath);
+        instrument::count(member ? instrument::Counter::MemberHit : instrument::Counter::MemberMiss);
+        return member;
+    }
+
+    // Applies a parsed command to its resolved object, appending the result
+    // text to out. A delta records the change bits it takes in taken, if given.
+    static Status apply(const Command& command, ObjectRef ref, std::string& out,
+                        TakenChanges* taken = nullptr) {
+        switch (command.operation) {
+            case Operation::Stats:
+                instrument::report(out);
+                if (!command.value.empty()) instrument::reset();
+                return Status::Ok;
+            case Operation::Unwatch: {
+                uint64_t id = 0;
+                if (!TypeTraits<uint64_t>::tryFromString(command.value, id)) return Status::InvalidCommand;
+                return WatchTable::remove(id) ? Status::Ok : Status::WatchNotFound;
+            }
+            default:
+                break;
+        }
+        if (isQuery(command)) return applyQuery(command, out);
+        if (!ref) return Status::ObjectNotFound;
+
+        switch (command.operation) {
+            case Operation::Dump:
+                ref.type->dump(ref.object, out);
+                return Status::Ok;
+            case Operation::Load:
+                return load_fields(*ref.type, ref.object, command.value);
+            case Operation::Delta:
+                ref.type->delta(ref.object, out, taken);
+                return Status::Ok;
+            default:
+                break;
+        }
+
+        BoundMember member = resolveMember(command, ref);
+        if (!member) return Status::MemberNotFound;
+
+        instrument::ScopedStage timer(instrument::Stage::Convert);
+        switch (command.operation) {
+            case Operation::Watch: {
+                WatchTable::SubscriberId subscriber = watchSubscriber.load(std::memory_order_relaxed);
+                if (subscriber == 0) return Status::NoSubscriber;
+                std::string_view path(command.objectId.data(),
+                                      command.memberPath.data() + command.memberPath.size() -
+                                      command.objectId.data());
+                WatchTable::WatchId id = WatchTable::add(
+                    subscriber, path, PathHandle::bind(command.objectId, ref, member), member);
+                if (id == 0) return Status::NoSubscriber;
+                append_value(out, id);
+                return Status::Ok;
+            }
+            case Operation::Set:
+                if (!member.setValue(command.value)) return Status::InvalidValue;
+                out.append(command.value);
+                return Status::Ok;
+            default:
+                member.appendValue(out);
+                return Status::Ok;
+        }
+    }
+
+    // Splits a script on newlines and ';', skipping blank commands.
+    template<typename Fn>
+    static void forEachCommand(std::string_view script, Fn&& fn) {
+        size_t pos = 0;
+        while (pos < script.size()) {
+            size_t end = script.find_first_of(";\n", pos);
+            if (end == std::string_view::npos) end = script.size();
+            std::string_view cmd = script.substr(pos, end - pos);
+            if (!cmd.empty() && cmd.back() == '\r') cmd.remove_suffix(1);
+            if (cmd.find_first_not_of(' ') != std::string_view::npos) fn(cmd);
+            pos = end + 1;
+        }
+    }
+
+    template<typename... Ts, size_t... Is>
+    static Status read(const std::string_view (&paths)[sizeof...(Ts)], std::index_sequence<Is...>,
+                       Ts&... out) {
+        constexpr size_t count = sizeof...(Ts);
+        const BoundMember members[count] = { resolve(paths[Is])... };
+        for (const BoundMember& member : members) {
+            if (!member) return Status::MemberNotFound;
+        }
+        const void* sources[count] = { members[Is].template as<Ts>()... };
+        for (const void* source : sources) {
+            if (!source) return Status::InvalidValue;
+        }
+
+        std::array<size_t, count> stripes = { SeqLocks::stripeOf(members[Is].owner())... };
+        std::sort(stripes.begin(), stripes.end());
+        size_t distinct = std::unique(stripes.begin(), stripes.end()) - stripes.begin();
+
+        if constexpr ((std::is_trivially_copyable_v<Ts> && ...)) {
+            std::array<uint64_t, count> seen{};
+            for (unsigned spins = 0;; SeqLocks::pause(spins++)) {
+                bool stable = true;
+                for (size_t i = 0; i < distinct && stable; ++i) {
+                    seen[i] = SeqLocks::sequence(stripes[i]).load(std::memory_order_acquire);
+                    stable = (seen[i] & 1) == 0;
+                }
+                if (!stable) continue;
+                (seq_copy::observe(&out, sources[Is], sizeof(Ts)), ...);
+                for (size_t i = 0; i < distinct && stable; ++i) {
+                    stable = SeqLocks::sequence(stripes[i]).load(std::memory_order_relaxed) == seen[i];
+                }
+                if (stable) return Status::Ok;
+            }
+        } else {
+            std::array<uint64_t, count> held;
+            for (size_t i = 0; i < distinct; ++i) held[i] = SeqLocks::lock(stripes[i]);
+            ((out = *static_cast<const Ts*>(sources[Is])), ...);
+            for (size_t i = distinct; i-- > 0;) SeqLocks::unlock(stripes[i], held[i]);
+            return Status::Ok;
+        }
+    }
+
+    // Reverts a delta or watch whose result the caller could not take; a
+    // delta's change bits come back from what it took.
+    static void undo(const Command& command, const TakenChanges& taken, std::string_view result) {
+        if (command.operation == Operation::Delta) {
+            for (auto [tracker, bits] : taken) tracker->restore(bits);
+        } else if (command.operation == Operation::Watch) {
+            uint64_t id = 0;
+            if (TypeTraits<uint64_t>::tryFromString(result, id)) WatchTable::remove(id);
+        }
+    }
+
+    static bool addressesObject(const Command& command) {
+        return command.operation != Operation::Stats && command.operation != Operation::Unwatch &&
+               !isQuery(command);
+    }
+
+    // Finds the command's object, or nothing for commands without one. The
+    // id is hashed only here, once it is known to be looked up by name;
+    // "#<handle>" ids are never hashed.
+    static ObjectRef lookup(const Command& command) {
+        if (!addressesObject(command)) return ObjectRef();
+        instrument::ScopedStage timer(instrument::Stage::Lookup);
+        return counted(ObjectIndex::find(command.objectId));
+    }
+
+    // Same, for an id the caller has already hashed.
+    static ObjectRef lookup(const Command& command, size_t hash) {
+        if (!addressesObject(command)) return ObjectRef();
+        instrument::ScopedStage timer(instrument::Stage::Lookup);
+        return counted(ObjectIndex::find(command.objectId, hash));
+    }
+
+    static ObjectRef counted(ObjectRef ref) {
+        instrument::count(ref ? instrument::Counter::LookupHit : instrument::Counter::LookupMiss);
+        return ref;
+    }
+
+    static void executeOne(std::string_view cmd, BatchResult& out) {
+        instrument::ScopedStage timer(instrument::Stage::Command);
+        BatchResult::Entry entry{ Status::Ok, out.buffer.size(), 0 };
+        Command command;
+        entry.status = parseCommand(cmd, command);
+        if (entry.status == Status::Ok) {
+            ObjectRef ref;
+            if (!addressesObject(command) || ObjectIndex::isHandle(command.objectId)) {
+                ref = lookup(command);  // nothing to cache, or cheaper than the cache
+            } else {
+                size_t hash = ObjectIndex::hashId(command.objectId);
+                ObjectRef* cached = out.objects.find(command.objectId, hash);
+                if (cached) instrument::count(instrument::Counter::BatchCacheHit);
+                ref = cached ? *cached : lookup(command, hash);
+                if (!cached) out.objects.tryEmplace(command.objectId, hash, ref);
+            }
+            entry.status = apply(command, ref, out.buffer);
+        }
+        if (entry.status != Status::Ok) {
+            out.buffer.resize(entry.offset);
+        }
+        entry.length = out.buffer.size() - entry.offset;
+        out.entries.push_back(entry);
+    }
+
+public:
+    // Executes one command, writing the member value (get) or the accepted
+    // value (set) to result. Works entirely on views into cmd, so callers
+    // holding a raw buffer need not build a std::string first.
+    static Status execute(std::string_view cmd, std::string& result) {
+        instrument::ScopedStage timer(instrument::Stage::Command);
+        result.clear();
+        Command command;
+        Status status = parseCommand(cmd, command);
+        if (status != Status::Ok) return status;
+        return apply(command, lookup(command), result);
+    }
+
+    // Same, for callers that know the addressed objects are Ts: the member
+    // path is walked by Reflector<T>::execute, specialized for T at compile
+    // time. Objects of another type, pattern queries and commands other
+    // than get, set, dump, load and delta take the generic path.
+    template<typename T>
+    static Status executeAs(std::string_view cmd, std::string& result) {
+        instrument::ScopedStage timer(instrument::Stage::Command);
+        result.clear();
+        Command command;
+        Status status = parseCommand(cmd, command);
+        if (status != Status::Ok) return status;
+        ObjectRef ref = lookup(command);
+        switch (command.operation) {
+            case Operation::Get:
+            case Operation::Set:
+            case Operation::Dump:
+            case Operation::Load:
+            case Operation::Delta:
+                if (T* object = ref.as<T>()) {
+                    return Reflector<T>::execute(*object, command.operation, command.memberPath,
+                                                 command.value, result);
+                }
+                break;
+            default:
+                break;
+        }
+        return apply(command, ref, result);
+    }
+
+    // Same, formatting the result into [buffer, buffer + capacity) and
+    // setting length to its size. Get and set write straight into the
+    // buffer; other commands go through a per-thread scratch string. A
+    // command whose result would not fit fails with BufferTooSmall and
+    // leaves no side effect: a set before it applies (a pattern set when
+    // its number of matches would not fit), "stats reset" before it
+    // resets, and a delta or watch is undone (its change bits are set
+    // again, its watch removed).
+    static Status execute(std::string_view cmd, char* buffer, size_t capacity, size_t& length) {
+        instrument::ScopedStage timer(instrument::Stage::Command);
+        length = 0;
+        Command command;
+        Status status = parseCommand(cmd, command);
+        if (status != Status::Ok) return status;
+        ObjectRef ref = lookup(command);
+
+        if ((command.operation != Operation::Get && command.operation != Operation::Set) ||
+            isQuery(command)) {
+            thread_local std::string scratch;
+            thread_local TakenChanges taken;
+            scratch.clear();
+            taken.clear();
+            if (command.operation == Operation::Stats) {
+                instrument::report(scratch);
+                if (scratch.size() > capacity) return Status::BufferTooSmall;
+                if (!command.value.empty()) instrument::reset();
+            } else {
+                if (command.operation == Operation::Set && isQuery(command)) {
+                    char digits[24];
+                    size_t matches = query(patternOf(command), [](std::string_view, const BoundMember&) {});
+                    if (std::to_chars(digits, digits + sizeof(digits), matches).ptr - digits >
+                        static_cast<std::ptrdiff_t>(capacity)) {
+                        return Status::BufferTooSmall;
+                    }
+                }
+                status = apply(command, ref, scratch, &taken);
+                if (status != Status::Ok) return status;
+                if (scratch.size() > capacity) {
+                    undo(command, taken, scratch);
+                    return Status::BufferTooSmall;
+                }
+            }
+            length = std::copy(scratch.begin(), scratch.end(), buffer) - buffer;
+            return Status::Ok;
+        }
+
+        if (!ref) return Status::ObjectNotFound;
+        BoundMember member = resolveMember(command, ref);
+        if (!member) return Status::MemberNotFound;
+
+        instrument::ScopedStage convert(instrument::Stage::Convert);
+        if (command.operation == Operation::Set) {
+            if (command.value.size() > capacity) return Status::BufferTooSmall;
+            if (!member.setValue(command.value)) return Status::InvalidValue;
+            length = std::copy(command.value.begin(), command.value.end(), buffer) - buffer;
+            return Status::Ok;
+        }
+        char* end = member.writeValue(buffer, buffer + capacity);
+        if (!end) return Status::BufferTooSmall;
+        length = end - buffer;
+        return Status::Ok;
+    }
+
+    // Executes commands in order, resolving each distinct object id once
+    // per batch, and replaces out's contents with one entry per command.
+    static void executeBatch(const std::string_view* commands, size_t count, BatchResult& out) {
+        out.clear();
+        out.entries.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            executeOne(commands[i], out);
+        }
+    }
+
+    // Same, for a script of commands separated by newlines or ';'.
+    static void executeBatch(std::string_view script, BatchResult& out) {
+        out.clear();
+        forEachCommand(script, [&out](std::string_view cmd) { executeOne(cmd, out); });
+    }
+
+    // Compatibility wrapper: the result text, or an empty string on any error.
+    static std::string parseAndExecute(std::string_view cmd) {
+        std::string result;
+        return execute(cmd, result) == Status::Ok ? result : std::string();
+    }
+};
+
+// A multi-member set published as one change:
+//   Transaction txn;
+//   txn.set("cfg.host", "example.org");
+//   txn.set("cfg.port", 8080);
+//   txn.commit();
+// set() resolves the path and converts the value right away into a
+// detached copy, so the conversion cost and any rejection come before
+// anything is published. commit() then moves every staged value in while
+// holding the seqlocks of the members' owners, and only afterwards marks
+// change trackers and queues watches. An object destroyed or registered
+// elsewhere between set() and commit() fails the whole commit with
+// ObjectNotFound, as a PathHandle would. ReflectionParser::read() sees all
+// of a commit or none of it. Plain sets and direct member writes take no
+// seqlock and are not ordered against those readers. Whole Reflectable
+// members cannot be staged; set their fields instead.
+class Transaction {
+public:
+    Transaction() = default;
+    Transaction(const Transaction&) = delete;
+    Transaction& operator=(const Transaction&) = delete;
+    ~Transaction() { clear(); }
+
+    // Stages "<object>.<member path>" = value from text. A failed stage is
+    // also reported by commit(), which then applies nothing.
+    Status set(std::string_view path, std::string_view value) {
+        Target target;
+        Status status = resolve(path, target);
+        if (status == Status::Ok) {
+            void* staged = target.member.descriptor->ops->parse(value);
+            if (staged) {
+                stage(target, staged);
+            } else {
+                status = Status::InvalidValue;
+            }
+        }
+        return fail(status);
+    }
+
+    // Typed staging, without text conversion; the member must be exactly T.
+    template<typename T, typename = std::enable_if_t<
+        !std::is_convertible_v<const T&, std::string_view>>>
+    Status set(std::string_view path, T&& value) {
+        using Type = std::decay_t<T>;
+        Target target;
+        Status status = resolve(path, target);
+        if (status == Status::Ok && target.member.descriptor->type != type_id<Type>()) {
+            status = Status::InvalidValue;
+        }
+        if (status == Status::Ok) stage(target, new Type(std::forward<T>(value)));
+        return fail(status);
+    }
+
+    size_t size() const { return staged.size(); }
+
+    // Publishes every staged value, or none if a set() failed (returning
+    // the first failure). The transaction is empty afterwards either way.
+    Status commit() {
+        if (failure != Status::Ok) {
+            Status status = failure;
+            clear();
+            return status;
+        }
+        if (!revalidate()) {
+            clear();
+            return Status::ObjectNotFound;
+        }
+
+        held.clear();
+        for (const Staged& value : staged) held.push_back({ value.stripe, 0 });
+        std::sort(held.begin(), held.end());
+        held.erase(std::unique(held.begin(), held.end(), [](const auto& l, const auto& r) {
+            return l.first == r.first;
+        }), held.end());
+
+        for (auto& [stripe, sequence] : held) sequence = SeqLocks::lock(stripe);
+        for (const Staged& value : staged) {
+            const MemberDescriptor* descriptor = value.member.descriptor;
+            descriptor->ops->assign(descriptor->address(value.member.object), value.value);
+        }
+        for (size_t i = held.size(); i-- > 0;) SeqLocks::unlock(held[i].first, held[i].second + 2);
+
+        for (const Staged& value : staged) value.member.onSet();
+        clear();
+        return Status::Ok;
+    }
+
+    // Discards everything staged.
+    void abort() { clear(); }
+
+private:
+    // A resolved path, with the registration it was resolved through.
+    struct Target {
+        std::string_view objectId;
+        ObjectRef root;
+        BoundMember member;
+    };
+
+    struct Staged {
+        std::string objectId;
+        ObjectRef root;
+        BoundMember member;
+        void* value;
+        size_t stripe;
+    };
+
+    std::vector<Staged> staged;
+    std::vector<std::pair<size_t, uint64_t>> held;  // stripe, locked sequence
+    Status failure = Status::Ok;
+    size_t seenGeneration = 0;  // index generation before the first stage
+
+    Status resolve(std::string_view path, Target& target) {
+        if (staged.empty()) {
+            seenGeneration = ObjectIndex::getGeneration().load(std::memory_order_acquire);
+        }
+        std::string_view memberPath;
+        if (!ReflectionParser::splitPath(path, target.objectId, memberPath)) {
+            return Status::InvalidCommand;
+        }
+        target.root = ObjectIndex::find(target.objectId);
+        if (!target.root) return Status::ObjectNotFound;
+        target.member = resolve_path(*target.root.type, target.root.object, memberPath);
+        if (!target.member) return Status::MemberNotFound;
+        return target.member.descriptor->ops ? Status::Ok : Status::InvalidValue;
+    }
+
+    void stage(const Target& target, void* value) {
+        staged.push_back({ std::string(target.objectId), target.root, target.member, value,
+                           SeqLocks::stripeOf(target.member.owner()) });
+    }
+
+    // Whether every staged member's object is still registered where it
+    // was resolved; only looked up again if the index changed meanwhile.
+    bool revalidate() const {
+        if (ObjectIndex::getGeneration().load(std::memory_order_acquire) == seenGeneration) {
+            return true;
+        }
+        for (const Staged& value : staged) {
+            ObjectRef current = ObjectIndex::find(value.objectId);
+            if (current.object != value.root.object || current.type != value.root.type) return false;
+        }
+        return true;
+    }
+
+    Status fail(Status status) {
+        if (failure == Status::Ok) failure = status;
+        return status;
+    }
+
+    void clear() {
+        for (const Staged& value : staged) value.member.descriptor->ops->destroy(value.value);
+        staged.clear();
+        failure = Status::Ok;
+    }
+};
+
+// Runs big batches on several threads. Commands are partitioned by the
+// object they address, so each object is touched by one thread only and
+// needs no locking, and commands on one object run in submission order.
+// Batches containing pattern queries run serially.
+// Objects that overlap in memory (a registered member of another object
+// in the same batch) share their container's partition. Each thread
+// starts at its own partitions and steals unclaimed ones when done, which
+// evens out skewed batches (a single hot object still runs serially).
+// Results are gathered in submission order, as executeBatch produces them.
+class CommandPool {
+public:
+    // threads includes the calling thread, which works during execute().
+    explicit CommandPool(size_t threads = std::thread::hardware_concurrency())
+        : threadCount(std::max<size_t>(1, threads))
+        , partitions(threadCount * 4) {
+        for (size_t i = 1; i < threadCount; ++i) {
+            workers.emplace_back([this, i] { workerLoop(i); });
+        }
+    }
+
+    ~CommandPool() {
+        {
+            std::lock_guard lock(mutex);
+            shuttingDown = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    CommandPool(const CommandPool&) = delete;
+    CommandPool& operator=(const CommandPool&) = delete;
+
+    size_t size() const { return threadCount; }
+
+    // Batches below this size run on the calling thread alone.
+    static constexpr size_t min_parallel = 64;
+
+    // Same contract as ReflectionParser::executeBatch. Not reentrant: one
+    // execute() at a time per pool.
+    void execute(const std::string_view* commands, size_t count, BatchResult& out) {
+        if (threadCount == 1 || count < min_parallel) {
+            ReflectionParser::executeBatch(commands, count, out);
+            return;
+        }
+        parsed.resize(count);
+
+        // Parse and look up in contiguous slices.
+        size_t slice = (count + threadCount - 1) / threadCount;
+        runOnAll([&](size_t thread) {
+            size_t end = std::min(count, (thread + 1) * slice);
+            for (size_t i = thread * slice; i < end; ++i) {
+                Parsed& entry = parsed[i];
+                entry.status = ReflectionParser::parseCommand(commands[i], entry.command);
+                entry.ref = entry.status == Status::Ok
+                    ? ReflectionParser::lookup(entry.command)
+                    : ObjectRef();
+            }
+        });
+
+        // Pattern queries touch objects in every partition.
+        for (size_t i = 0; i < count; ++i) {
+            if (parsed[i].status == Status::Ok && ReflectionParser::isQuery(parsed[i].command)) {
+                ReflectionParser::executeBatch(commands, count, out);
+                return;
+            }
+        }
+
+        assignPartitions(count);
+
+        for (Partition& partition : partitions) partition.claimed.store(false, std::memory_order_relaxed);
+        runOnAll([&](size_t thread) {
+            size_t first = thread * partitions.size() / threadCount;
+            for (size_t k = 0; k < partitions.size(); ++k) {
+                Partition& partition = partitions[(first + k) % partitions.size()];
+                if (partition.claimed.exchange(true, std::memory_order_acquire)) continue;
+                runPartition(partition);
+            }
+        });
+
+        out.clear();
+        out.entries.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            const Partition& partition = partitions[parsed[i].partition];
+            BatchResult::Entry entry = partition.entries[parsed[i].slot];
+            size_t offset = out.buffer.size();
+            out.buffer.append(partition.text, entry.offset, entry.length);
+            entry.offset = offset;
+            out.entries.push_back(entry);
+        }
+    }
+
+private:
+    struct Parsed {
+        ReflectionParser::Command command;
+        Status status;
+        ObjectRef ref;
+        size_t partition;
+        size_t slot;    // position within the partition
+    };
+
+    struct Partition {
+        std::vector<size_t> commands;   // indices into parsed, in order
+        std::vector<BatchResult::Entry> entries;
+        std::string text;
+        std::atomic<bool> claimed{false};
+    };
+
+    struct Span {
+        uintptr_t begin;
+        uintptr_t end;
+        uintptr_t outer;    // start of the outermost object containing it
+    };
+
+    size_t threadCount;
+    std::vector<Partition> partitions;
+    std::vector<Parsed> parsed;
+    std::vector<Span> spans;
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    // The current job, type-erased without allocating.
+    void (*job)(void* context, size_t thread) = nullptr;
+    void* jobContext = nullptr;
+    uint64_t round = 0;
+    size_t running = 0;
+    bool shuttingDown = false;
+
+    // Maps every command to the partition of its outermost object.
+    void assignPartitions(size_t count) {
+        spans.clear();
+        for (size_t i = 0; i < count; ++i) {
+            if (const ObjectRef& ref = parsed[i].ref) {
+                uintptr_t begin = reinterpret_cast<uintptr_t>(ref.object);
+                spans.push_back({ begin, begin + ref.type->size, 0 });
+            }
+        }
+        std::sort(spans.begin(), spans.end(), [](const Span& l, const Span& r) {
+            return l.begin != r.begin ? l.begin < r.begin : l.end > r.end;
+        });
+        uintptr_t outer = 0, coveredEnd = 0;
+        for (Span& span : spans) {
+            if (span.begin >= coveredEnd) outer = span.begin;
+            coveredEnd = std::max(coveredEnd, span.end);
+            span.outer = outer;
+        }
+
+        for (Partition& partition : partitions) {
+            partition.commands.clear();
+            partition.entries.clear();
+            partition.text.clear();
+        }
+        for (size_t i = 0; i < count; ++i) {
+            Parsed& entry = parsed[i];
+            size_t target = 0;
+            if (entry.ref) {
+                uintptr_t begin = reinterpret_cast<uintptr_t>(entry.ref.object);
+                auto span = std::lower_bound(spans.begin(), spans.end(), begin,
+                    [](const Span& s, uintptr_t address) { return s.begin < address; });
+                target = std::hash<uintptr_t>{}(span->outer) % partitions.size();
+            }
+            entry.partition = target;
+            entry.slot = partitions[target].commands.size();
+            partitions[target].commands.push_back(i);
+        }
+    }
+
+    void runPartition(Partition& partition) {
+        for (size_t i : partition.commands) {
+            Parsed& entry = parsed[i];
+            BatchResult::Entry result{ entry.status, partition.text.size(), 0 };
+            if (result.status == Status::Ok) {
+                result.status = ReflectionParser::apply(entry.command, entry.ref, partition.text);
+            }
+            if (result.status != Status::Ok) partition.text.resize(result.offset);
+            result.length = partition.text.size() - result.offset;
+            partition.entries.push_back(result);
+        }
+    }
+
+    // Runs fn(thread) on every worker and the caller; returns when all finish.
+    template<typename Fn>
+    void runOnAll(Fn&& fn) {
+        {
+            std::lock_guard lock(mutex);
+            job = [](void* context, size_t thread) { (*static_cast<Fn*>(context))(thread); };
+            jobContext = &fn;
+            running = workers.size();
+            ++round;
+        }
+        wake.notify_all();
+        job(jobContext, 0);
+        std::unique_lock lock(mutex);
+        done.wait(lock, [this] { return running == 0; });
+    }
+
+    void workerLoop(size_t thread) {
+        uint64_t seen = 0;
+        for (;;) {
+            std::unique_lock lock(mutex);
+            wake.wait(lock, [&] { return shuttingDown || round != seen; });
+            if (shuttingDown) return;
+            seen = round;
+            lock.unlock();
+            job(jobContext, thread);
+            lock.lock();
+            if (--running == 0) done.notify_one();
+        }
+    }
+};
+
+} // namespace reflection